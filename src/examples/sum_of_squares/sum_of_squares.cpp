@@ -49,8 +49,9 @@ int main(int argc, char **argv){
 
     // The values in the textfile are read as floating point numbers
     // in a vector, then the sum of their squares is computed, and
-    // finally the result is reduced on a single processor.
-    auto result = dText.map(string2float).map(sum_of_squares).reduce([] (float& f1, float& f2){return f1+f2;});
+    // finally the result is reduced on a single processor. Since the
+    // reduction is a standard sum of numbers, it is done by MPI itself.
+    auto result = dText.map(string2float).map(sum_of_squares).reduce(std::plus<float>());
 
     // Finally, the content of the ReducedData object orderedData is printed out using a lambda function as print function.
     result.printData([](float& f) {cout << "Final result : " << f << endl;});
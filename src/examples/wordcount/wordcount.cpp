@@ -1,40 +1,75 @@
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <iostream>
 #include <unordered_map>
 #include <map>
+#include <string_view>
 #include <mpi_capsule.hpp>
 
 using namespace std;
 
-/* We define a function that counts the words in an std::string object
-and saves them and their number of occurrences in a std::unordered_map. */
-unordered_map<string,int> count_words(string& str){
+/* We define a function that counts the words in a TextPartition object and saves them
+and their number of occurrences in a std::unordered_map. The words are read directly in
+the partition through std::string_view objects, without copying its text. */
+unordered_map<string,int> count_words(TextPartition& partition){
 	unordered_map<string,int> wordcount;
 
-	char* c_text = new char[str.size()+1];
-	strcpy(c_text, str.c_str());
-	c_text[str.size()] = '\0';
-
-	char* c_word = strtok(c_text, " \n");
-	while (c_word){
-		std::string word(c_word);
-		if (!word.empty())
-			wordcount[word]++;
-		c_word = strtok(NULL, " \n");
+	string_view text = partition.view();
+	size_t pos = 0;
+	while (pos < text.size()){
+		size_t next = text.find_first_of(" \n", pos);
+		if (next == string_view::npos)
+			next = text.size();
+		if (next > pos)
+			wordcount[string(text.substr(pos, next-pos))]++;
+		pos = next+1;
 	}
-	delete [] c_text;
 
 	return wordcount;
 }
 
-/* We define a function that takes two unordered_map objects as input and merges them into a single one. */
-unordered_map<string,int> merge(unordered_map<string,int>& mapA, unordered_map<string,int>& mapB){
-	unordered_map<string,int> newMap(mapA);
+/* We define a function that merges the word counts of an unordered_map into another one. The
+counts are added in place in 'counts', so the maps aren't copied during the reduction. */
+void merge(unordered_map<string,int>& counts, unordered_map<string,int>&& other){
+	for (auto it=other.begin(); it!=other.end(); ++it)
+		counts[(*it).first] += (*it).second;
+}
+
+/* We define a function that finds the longest words of a TextPartition object, and a
+function that keeps the longest words of two lists, in alphabetical order. */
+vector<string> longest_words(TextPartition& partition){
+	vector<string> longest;
+
+	string_view text = partition.view();
+	size_t pos = 0;
+	while (pos < text.size()){
+		size_t next = text.find_first_of(" \n", pos);
+		if (next == string_view::npos)
+			next = text.size();
+		if (next > pos && (longest.empty() || next-pos >= longest[0].size())){
+			if (!longest.empty() && next-pos > longest[0].size())
+				longest.clear();
+			longest.push_back(string(text.substr(pos, next-pos)));
+		}
+		pos = next+1;
+	}
+
+	sort(longest.begin(), longest.end());
+	longest.erase(unique(longest.begin(), longest.end()), longest.end());
+	return longest;
+}
 
-	for (auto it=mapB.begin(); it!=mapB.end(); ++it)
-		newMap[(*it).first] += (*it).second;
+void keep_longest(vector<string>& longest, vector<string>&& other){
+	if (other.empty())
+		return;
+	if (longest.empty() || other[0].size() > longest[0].size())
+		longest.clear();
+	if (longest.empty() || other[0].size() == longest[0].size())
+		longest.insert(longest.end(), other.begin(), other.end());
 
-	return newMap;
+	sort(longest.begin(), longest.end());
+	longest.erase(unique(longest.begin(), longest.end()), longest.end());
 }
 
 /* We define a function to sort the elements of an unordered_map and return them in a map. */
@@ -54,14 +89,20 @@ int main(int argc, char **argv){
 		double t1 = MPI_Wtime();
 
 		// The text in the file entered as first argument to the program is
-		// read in parallel on the processors.
-		auto dText = context.textFile(argv[1], ' ');
+		// mapped in memory in parallel on the processors.
+		auto dText = context.textPartition(argv[1], ' ');
 
 		double t2 = MPI_Wtime();
 
 		// The words are counted locally by each processor on its part of the file,
-		// and the result of the counting is then reduced to a single processor.
-		auto counts = dText.map(count_words).reduce(merge);
+		// and the result of the counting is then reduced to a single processor. The
+		// longest words are searched for at the same time : both reductions are started
+		// without waiting, and they progress together although their data have
+		// different types.
+		auto pendingCounts = dText.map(count_words).reduceAsync(merge);
+		auto pendingLongest = dText.map(longest_words).reduceAsync(keep_longest);
+		auto counts = pendingCounts.wait();
+		auto longest = pendingLongest.wait();
 
 		double t3 = MPI_Wtime();
 
@@ -77,6 +118,7 @@ int main(int argc, char **argv){
 		auto orderedData = counts.map(sortMap);
 		// Finally, the content of the ReducedData object orderedData is printed out using a lambda function as print function.
 		orderedData.printData([](map<string,int>& map) { for (auto kv : map) cout << kv.first << " : " << kv.second << endl; });
+		longest.printData([](vector<string>& words) { for (auto& word : words) cout << "Longest word : " << word << endl; });
 
 	}
 	// When calling 'MPI_Context::textFile()', a try catch block must always be used
@@ -0,0 +1,96 @@
+#ifndef __BUFFERARCHIVE_H__
+#define __BUFFERARCHIVE_H__
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cereal/cereal.hpp>
+
+/* Cereal archives writing the data in a std::vector<char> and reading it from a block of
+   memory, instead of going through a std::stringstream. The data is written exactly like
+   by cereal::BinaryOutputArchive, so both archives can read the data written by the other. */
+class BufferOutputArchive : public cereal::OutputArchive<BufferOutputArchive, cereal::AllowEmptyClassElision>
+{
+	private :
+
+	std::vector<char>& buffer;
+
+	public :
+
+	/**
+	 \brief This constructor creates an archive appending the data to 'output'. The memory of
+			'output' is kept, so a vector used for several serializations is only allocated
+			once if it is cleared between them.
+	*/
+	BufferOutputArchive(std::vector<char>& output) : cereal::OutputArchive<BufferOutputArchive, cereal::AllowEmptyClassElision>(this), buffer(output){}
+
+	void saveBinary(const void* data, std::size_t size){
+		const char* bytes = static_cast<const char*>(data);
+		buffer.insert(buffer.end(), bytes, bytes+size);
+	}
+};
+
+class BufferInputArchive : public cereal::InputArchive<BufferInputArchive, cereal::AllowEmptyClassElision>
+{
+	private :
+
+	const char* position;
+	const char* end;
+
+	public :
+
+	/**
+	 \brief This constructor creates an archive reading the 'size' bytes at 'data', which must
+			exist as long as the archive.
+	*/
+	BufferInputArchive(const char* data, std::size_t size) : cereal::InputArchive<BufferInputArchive, cereal::AllowEmptyClassElision>(this), position(data), end(data+size){}
+
+	void loadBinary(void* const data, std::size_t size){
+		if (size > static_cast<std::size_t>(end-position))
+			throw cereal::Exception("Failed to read " + std::to_string(size) + " bytes from input buffer! " + std::to_string(end-position) + " bytes left");
+
+		std::memcpy(data, position, size);
+		position += size;
+	}
+};
+
+template<class T> inline
+typename std::enable_if<std::is_arithmetic<T>::value, void>::type
+CEREAL_SAVE_FUNCTION_NAME(BufferOutputArchive& ar, T const& t){
+	ar.saveBinary(std::addressof(t), sizeof(t));
+}
+
+template<class T> inline
+typename std::enable_if<std::is_arithmetic<T>::value, void>::type
+CEREAL_LOAD_FUNCTION_NAME(BufferInputArchive& ar, T& t){
+	ar.loadBinary(std::addressof(t), sizeof(t));
+}
+
+template<class Archive, class T> inline
+CEREAL_ARCHIVE_RESTRICT(BufferInputArchive, BufferOutputArchive)
+CEREAL_SERIALIZE_FUNCTION_NAME(Archive& ar, cereal::NameValuePair<T>& t){
+	ar(t.value);
+}
+
+template<class Archive, class T> inline
+CEREAL_ARCHIVE_RESTRICT(BufferInputArchive, BufferOutputArchive)
+CEREAL_SERIALIZE_FUNCTION_NAME(Archive& ar, cereal::SizeTag<T>& t){
+	ar(t.size);
+}
+
+template<class T> inline
+void CEREAL_SAVE_FUNCTION_NAME(BufferOutputArchive& ar, cereal::BinaryData<T> const& bd){
+	ar.saveBinary(bd.data, static_cast<std::size_t>(bd.size));
+}
+
+template<class T> inline
+void CEREAL_LOAD_FUNCTION_NAME(BufferInputArchive& ar, cereal::BinaryData<T>& bd){
+	ar.loadBinary(bd.data, static_cast<std::size_t>(bd.size));
+}
+
+CEREAL_REGISTER_ARCHIVE(BufferOutputArchive)
+CEREAL_REGISTER_ARCHIVE(BufferInputArchive)
+
+CEREAL_SETUP_ARCHIVE_TRAITS(BufferInputArchive, BufferOutputArchive)
+
+#endif
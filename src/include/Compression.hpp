@@ -0,0 +1,163 @@
+#ifndef __COMPRESSION_H__
+#define __COMPRESSION_H__
+
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include "CompressionError.hpp"
+
+/* A fast LZ77 codec in the style of LZ4, used to compress the serialized data sent between
+   the processors. The compressed data is a sequence of blocks, each made of a token byte
+   (number of literals in its 4 high bits, length of the match minus 4 in its 4 low bits,
+   15 meaning that the length continues in the next bytes, 255 by 255), the literals, and
+   the 2 bytes (little endian) of the offset of the match. The last block has no match. */
+class Compression
+{
+	private :
+
+	static const int hashBits = 16;
+	static const std::size_t minMatch = 4;
+	static const std::size_t maxOffset = 65535;
+	// The last bytes of the data are always literals, so the matches can be read 4 bytes
+	// at a time without going past the end of the data.
+	static const std::size_t lastLiterals = 5;
+
+	static std::uint32_t read32(const char* p){
+		std::uint32_t value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	static std::uint32_t hash(std::uint32_t sequence){
+		return (sequence*2654435761u) >> (32-hashBits);
+	}
+
+	static void writeLength(std::vector<char>& output, std::size_t length){
+		while (length >= 255){
+			output.push_back((char)255);
+			length -= 255;
+		}
+		output.push_back((char)length);
+	}
+
+	// Appends a block made of 'nLiterals' literals and of a match of 'matchLength' bytes
+	// (no match when it is 0) to 'output'.
+	static void writeBlock(std::vector<char>& output, const char* literals, std::size_t nLiterals, std::size_t offset, std::size_t matchLength){
+		std::size_t matchCode = matchLength == 0 ? 0 : matchLength-minMatch;
+		output.push_back((char)(((nLiterals < 15 ? nLiterals : 15) << 4) | (matchCode < 15 ? matchCode : 15)));
+		if (nLiterals >= 15)
+			writeLength(output, nLiterals-15);
+		output.insert(output.end(), literals, literals+nLiterals);
+
+		if (matchLength != 0){
+			output.push_back((char)(offset & 0xFF));
+			output.push_back((char)(offset >> 8));
+			if (matchCode >= 15)
+				writeLength(output, matchCode-15);
+		}
+	}
+
+	static std::size_t readLength(const unsigned char*& in, const unsigned char* end, std::size_t length){
+		if (length != 15)
+			return length;
+
+		unsigned char byte;
+		do {
+			if (in == end)
+				throw CompressionError();
+			byte = *in++;
+			length += byte;
+		} while (byte == 255);
+		return length;
+	}
+
+	public :
+
+	/**
+	 \brief This method compresses 'size' bytes, and appends the compressed data to 'output'.
+	 \param data The address of the bytes to compress.
+	 \param size The number of bytes to compress.
+	 \param output The std::vector<char> in which the compressed data is appended.
+	*/
+	static void compress(const char* data, std::size_t size, std::vector<char>& output){
+		output.reserve(output.size()+size/2+16);
+
+		std::size_t anchor = 0;
+		std::size_t pos = 0;
+		if (size > minMatch+lastLiterals+4){
+			// The last position seen for each hash of 4 bytes (+1, 0 meaning none).
+			std::vector<std::uint32_t> table(1 << hashBits, 0);
+			std::size_t limit = size-lastLiterals-minMatch;
+			while (pos < limit){
+				std::uint32_t sequence = read32(data+pos);
+				std::uint32_t& entry = table[hash(sequence)];
+				std::size_t candidate = entry;
+				entry = pos+1;
+
+				if (candidate != 0 && pos-(candidate-1) <= maxOffset && read32(data+candidate-1) == sequence){
+					std::size_t match = candidate-1;
+					std::size_t length = minMatch;
+					while (pos+length < size-lastLiterals && data[match+length] == data[pos+length])
+						++length;
+
+					writeBlock(output, data+anchor, pos-anchor, pos-match, length);
+					pos += length;
+					anchor = pos;
+				}
+				else
+					// Data without matches is skipped faster and faster, as it is unlikely
+					// to compress.
+					pos += 1+((pos-anchor) >> 6);
+			}
+		}
+
+		writeBlock(output, data+anchor, size-anchor, 0, 0);
+	}
+
+	/**
+	 \brief This method decompresses data compressed by 'compress'.
+	 \param data The address of the compressed data.
+	 \param size The size in bytes of the compressed data.
+	 \param output The address where the data is decompressed.
+	 \param outputSize The size in bytes of the data once decompressed.
+	 \throw CompressionError if the compressed data is corrupted.
+	*/
+	static void decompress(const char* data, std::size_t size, char* output, std::size_t outputSize){
+		const unsigned char* in = reinterpret_cast<const unsigned char*>(data);
+		const unsigned char* end = in+size;
+		std::size_t out = 0;
+
+		while (in != end){
+			unsigned char token = *in++;
+
+			std::size_t nLiterals = readLength(in, end, token >> 4);
+			if (nLiterals > (std::size_t)(end-in) || nLiterals > outputSize-out)
+				throw CompressionError();
+			std::memcpy(output+out, in, nLiterals);
+			in += nLiterals;
+			out += nLiterals;
+
+			// The last block has no match.
+			if (in == end)
+				break;
+
+			if (end-in < 2)
+				throw CompressionError();
+			std::size_t offset = in[0] | (in[1] << 8);
+			in += 2;
+			std::size_t length = readLength(in, end, token & 0x0F)+minMatch;
+			if (offset == 0 || offset > out || length > outputSize-out)
+				throw CompressionError();
+
+			// The match may overlap the bytes it produces, so it is copied byte by byte.
+			for (std::size_t i = 0; i < length; ++i, ++out)
+				output[out] = output[out-offset];
+		}
+
+		if (out != outputSize)
+			throw CompressionError();
+	}
+};
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef __COMPRESSIONERROR_H__
+#define __COMPRESSIONERROR_H__
+
+#include <exception>
+
+class CompressionError : public std::exception{
+
+  virtual const char* what() const throw(){
+    return "A compressed message couldn't be decompressed.";
+  }
+
+};
+
+#endif
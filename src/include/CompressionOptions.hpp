@@ -0,0 +1,82 @@
+#ifndef __COMPRESSIONOPTIONS_H__
+#define __COMPRESSIONOPTIONS_H__
+
+#include <string>
+#include <cstddef>
+#include <cstdlib>
+
+class CompressionOptions
+{
+	private :
+
+	bool enabled;
+	// Smallest size in bytes of the serialized data compressed before being sent.
+	long long thresholdBytes;
+
+	public :
+
+	CompressionOptions() : enabled(false), thresholdBytes(64*1024){}
+
+	/**
+	 \brief This method enables or disables the compression of the serialized data sent
+			between the processors (it is disabled by default).
+	*/
+	CompressionOptions& setEnabled(bool enable){
+		enabled = enable;
+		return *this;
+	}
+
+	/**
+	 \brief This method sets the size in bytes of serialized data from which it is compressed
+			before being sent. Smaller data is always sent as is.
+	*/
+	CompressionOptions& setThresholdBytes(long long bytes){
+		thresholdBytes = bytes;
+		return *this;
+	}
+
+	bool isEnabled() const {
+		return enabled;
+	}
+
+	long long getThresholdBytes() const {
+		return thresholdBytes;
+	}
+
+	/**
+	 \brief This method tells whether serialized data of 'bytes' bytes must be compressed.
+	*/
+	bool applies(std::size_t bytes) const {
+		return enabled && (long long)bytes >= thresholdBytes;
+	}
+
+	/**
+	 \brief This method overrides the options with the ones defined in the environment :
+			MPICAPSULE_COMPRESSION ('on' or 'off') and MPICAPSULE_COMPRESSION_THRESHOLD.
+	*/
+	void loadEnvironment(){
+		const char* env = std::getenv("MPICAPSULE_COMPRESSION");
+		if (env != nullptr){
+			std::string value(env);
+			if (value == "on")
+				enabled = true;
+			else if (value == "off")
+				enabled = false;
+		}
+
+		env = std::getenv("MPICAPSULE_COMPRESSION_THRESHOLD");
+		if (env != nullptr)
+			thresholdBytes = std::atoll(env);
+	}
+
+	/**
+	 \brief This method returns the options used by all the transfers of the program that
+			aren't given their own options (see 'MPI_Context::setCompressionOptions').
+	*/
+	static CompressionOptions& current(){
+		static CompressionOptions options;
+		return options;
+	}
+};
+
+#endif
@@ -4,10 +4,22 @@
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <vector>
+#include <algorithm>
 #include <functional>
+#include <utility>
+#include <type_traits>
+#include <filesystem>
+#include <cstdio>
 #include "mpi.h"
 #include "MPI_SendRecv.hpp"
+#include "MPI_Types.hpp"
+#include "ReduceOps.hpp"
 #include "ReducedData.hpp"
+#include "Reduction.hpp"
+#include "PendingReduce.hpp"
+#include "FileError.hpp"
+#include "IOOptions.hpp"
 
 template <typename T>
 class DistributedData
@@ -17,90 +29,608 @@ class DistributedData
 	int procRank;
 	int nProcs;
 	int masterProc;
-	T data;
+	// The data of a processor is divided in one or more partitions, which are
+	// processed independently by 'map' and can be moved between processors.
+	std::vector<T> partitions;
+
+	// Combines the partitions of the processor, before the reduction of its data with
+	// the ones of the other processors.
+	template<typename Merge>
+	T mergePartitions(Merge& merge){
+		T localData(partitions[0]);
+		for (std::size_t i = 1; i < partitions.size(); ++i){
+			T partition(partitions[i]);
+			merge(localData, std::move(partition));
+		}
+		return localData;
+	}
+	
+	// Computes the prefix of each partition in the order of the ranks of the processors and
+	// of the partitions, including the partition itself or not (see 'scan' and 'exscan').
+	template<typename F>
+	std::vector<T> prefixes(F func, bool inclusive){
+		InPlaceCombiner<T, F> merge(func);
+		T localData = mergePartitions(merge);
+
+		// The combination of the data of the processors before this one.
+		T before = T();
+		bool hasBefore;
+		if constexpr (NativeOp<F, T>::value){
+			MPI_Exscan(&localData, &before, 1, mpi_type<T>::get(), NativeOp<F, T>::op(), MPI_COMM_WORLD);
+			hasBefore = procRank != 0;
+		}
+		else if constexpr (bitwise_copyable<T>::value){
+			UserOp<T> userOp(merge, false);
+			MPI_Exscan(&localData, &before, 1, userOp.getType(), userOp.getOp(), MPI_COMM_WORLD);
+			hasBefore = procRank != 0;
+		}
+		else
+			hasBefore = Reduction::exscan(localData, merge, before, MPI_COMM_WORLD);
+
+		std::vector<T> result;
+		result.reserve(partitions.size());
+		for (auto const& partition : partitions){
+			if (!inclusive)
+				result.push_back(hasBefore ? before : T());
+
+			T part(partition);
+			if (hasBefore)
+				merge(before, std::move(part));
+			else
+				before = std::move(part);
+			hasBefore = true;
+
+			if (inclusive)
+				result.push_back(before);
+		}
+
+		return result;
+	}
 	
 	public :
 	
-	DistributedData(int rank, int procs, int master) : procRank(rank), nProcs(procs), masterProc(master){}
-	DistributedData(int rank, int procs, int master, T localData) : procRank(rank), nProcs(procs), masterProc(master), data(localData){}
+	DistributedData(int rank, int procs, int master) : procRank(rank), nProcs(procs), masterProc(master), partitions(1){}
+	DistributedData(int rank, int procs, int master, T localData) : procRank(rank), nProcs(procs), masterProc(master){
+		partitions.push_back(std::move(localData));
+	}
+	DistributedData(int rank, int procs, int master, std::vector<T> localPartitions) : procRank(rank), nProcs(procs), masterProc(master), partitions(std::move(localPartitions)){
+		if (partitions.empty())
+			partitions.resize(1);
+	}
 	
+	/**
+	 \brief This method returns the data of the processor. When its data is divided in
+			several partitions, only the first one is returned (see 'getPartitions').
+	*/
 	T getData(){
-		return data;
+		return partitions[0];
 	}
 	
+	/**
+	 \brief This method replaces all the partitions of the processor by a single one
+			containing 'newData'.
+	*/
 	void setData(T newData){
-		data = newData;
+		partitions.clear();
+		partitions.push_back(std::move(newData));
+	}
+
+	std::vector<T> const& getPartitions() const {
+		return partitions;
+	}
+
+	int getNumPartitions() const {
+		return partitions.size();
 	}
 	
 	/**
-	 \brief This method applies the function entered as parameter on the data 
-			contained by the object in its 'data' attribute.
+	 \brief This method applies the function entered as parameter on each partition
+			of the data contained by the object.
 	 \param func A pointer to a function or a lambda function taking data of type T as input, 
 				and returning data of any type R.
 	 \return A new DistributedData object of type R, containing the result of the application
-			of 'func' on the data in 'data'.
+			of 'func' on each partition (it has the same number of partitions).
 	*/
 	template<typename R>
 	DistributedData<R> map(R (*func)(T&)){
-		R result = func(data);
-		DistributedData<R> resultData(procRank, nProcs, masterProc, result);
+		std::vector<R> results;
+		results.reserve(partitions.size());
+		for (auto& partition : partitions)
+			results.push_back(func(partition));
+		DistributedData<R> resultData(procRank, nProcs, masterProc, std::move(results));
 		return resultData;
 	}
 	
+	/**
+	 \brief This method moves a partition from a processor to another one, for example to
+			balance the load of the processors before an expensive 'map'. It must be called
+			by all the processors with the same arguments. A processor always keeps at least
+			one partition : nothing is moved if 'src' has a single partition.
+	 \param src The rank of the processor sending the partition.
+	 \param index The index of the partition in the partitions of 'src'.
+	 \param dest The rank of the processor receiving the partition. It is added after
+			its own partitions.
+	*/
+	void movePartition(int src, std::size_t index, int dest){
+		if (src == dest)
+			return;
+
+		// The source first tells the destination whether the partition is
+		// actually moved.
+		if (procRank == src){
+			int moved = (partitions.size() > 1 && index < partitions.size()) ? 1 : 0;
+			MPI_SendRecv::send(moved, 1, dest, 0, MPI_COMM_WORLD);
+			if (moved){
+				MPI_SendRecv::send(partitions[index], dest, 0, MPI_COMM_WORLD);
+				partitions.erase(partitions.begin()+index);
+			}
+		}
+		else if (procRank == dest){
+			int moved;
+			MPI_SendRecv::recv(moved, 1, src, 0, MPI_COMM_WORLD);
+			if (moved){
+				T partition;
+				MPI_SendRecv::recv(partition, src, 0, MPI_COMM_WORLD);
+				partitions.push_back(std::move(partition));
+			}
+		}
+	}
+
+	/**
+	 \brief This method moves partitions between the processors until the numbers of
+			partitions of any two processors differ by at most one. It must be called by
+			all the processors.
+	*/
+	void rebalance(){
+		int count = partitions.size();
+		std::vector<int> counts(nProcs);
+		MPI_Allgather(&count, 1, MPI_INT, counts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+
+		// All the processors compute the same moves from the same counts : the last
+		// partition of the most loaded processor goes to the least loaded one.
+		while (true){
+			int src = std::max_element(counts.begin(), counts.end())-counts.begin();
+			int dest = std::min_element(counts.begin(), counts.end())-counts.begin();
+			if (counts[src]-counts[dest] <= 1)
+				break;
+
+			movePartition(src, counts[src]-1, dest);
+			counts[src]--;
+			counts[dest]++;
+		}
+	}
+	
 	/**
 	 \brief This method reduces the data distributed in a set of DistributedData objects
 			on all processors in the MPI_WORLD_COMM communicator. It sends the data to a single 
 			processor, the master of the program, and it applies the function defined in 'func'
-			on the data during its reduction.
-	 \param func A pointer to a function or lambda function taking two objects of type T as input
-				and returning only one of the same type.
+			on the data during its reduction. The data is reduced inside each node before being
+			sent between the nodes (see 'Reduction::reduce').
+			Numbers combined with a standard operation are reduced by MPI itself with MPI_Reduce.
+			When T is bitwise copyable (numbers, or pairs, structs and arrays of numbers, see
+			bitwise_copyable), 'func' is wrapped in an MPI operation and the reduction is also done by MPI_Reduce, without
+			any serialization.
+	 \param func The function combining the data, which must be associative and commutative :
+				- an in-place combiner 'void func(T& acc, T&& incoming)', adding the data of
+				  'incoming' to 'acc' (it may steal the content of 'incoming'), which avoids
+				  copying the data at each step of the reduction ;
+				- a function taking two objects of type T as input and returning only one of
+				  the same type ;
+				- a function object for a standard operation on numbers : std::plus,
+				  std::multiplies, Min, Max, std::logical_and, std::logical_or, std::bit_and,
+				  std::bit_or or std::bit_xor (for example 'reduce(std::plus<float>())').
+				Lambda functions and other function objects can be used as well as pointers
+				to functions.
 	 \return A ReducedData<T> object on each processor in the program. Only the ReducedData object
 			on the master node will actually contain the result of the reduction, the rest will be empty.
 	*/
+	template<typename F>
+	ReducedData<T> reduce(F func){
+		InPlaceCombiner<T, F> merge(func);
+		// The partitions of each processor are first reduced locally.
+		T tmpData = mergePartitions(merge);
+
+		if constexpr (NativeOp<F, T>::value){
+			T reducedData = T();
+			MPI_Reduce(&tmpData, &reducedData, 1, mpi_type<T>::get(), NativeOp<F, T>::op(), masterProc, MPI_COMM_WORLD);
+			tmpData = reducedData;
+		}
+		else if constexpr (bitwise_copyable<T>::value){
+			UserOp<T> userOp(merge);
+			T reducedData(tmpData);
+			MPI_Reduce(&tmpData, &reducedData, 1, userOp.getType(), userOp.getOp(), masterProc, MPI_COMM_WORLD);
+			tmpData = reducedData;
+		}
+		else
+			Reduction::reduce(tmpData, merge, masterProc);
+
+		// Only the master node of the program has data in the ReducedData object it 
+		// returns. All the other nodes return empty ReducedData objects.
+		ReducedData<T> result(procRank, masterProc);
+		if (procRank==masterProc)
+			result.setData(std::move(tmpData));
+	
+		return result;
+	}
+
+	// Pointers to functions are also accepted through these overloads, so that the name of
+	// an overloaded function (like 'merge' when std::merge is visible) can be given.
 	ReducedData<T> reduce(T (*func)(T&,T&)){
-		// At the beginning of the reduction, all processors are active, and half 
-		// of them receives from the other half their data. 
-		int activeProcs(nProcs);
-		int receivers((nProcs+1)/2);
-		int nb_recv_odd(nProcs%2);
-		
-		T tmpData(data);
-		
-		while (activeProcs>1){
-			// A processor is a sender when its rank is higher than half the number of
-			// active processors and smaller than the number of active processors. 
-			// After a processor has sent its data to a receiver, it becomes 'inactive'.
-			if (procRank >= receivers && procRank < activeProcs){
-				MPI_SendRecv::send(tmpData, procRank-receivers, 0, MPI_COMM_WORLD);
+		return reduce<T (*)(T&,T&)>(func);
+	}
+
+	ReducedData<T> reduce(void (*func)(T&,T&&)){
+		return reduce<void (*)(T&,T&&)>(func);
+	}
+
+	/**
+	 \brief This method reduces the data distributed in a set of DistributedData objects like
+			'reduce', along a tree of at most 'depth' levels whose shape is chosen from it :
+			each processor receives the data of up to ceil(nProcs^(1/depth)) processors, and
+			combines it in the order in which it arrives. A shallow tree reaches the master in
+			fewer sequential steps, which is best when the data is small and 'func' is cheap,
+			while a deep one spreads the combinations over more processors.
+	 \param func The function combining the data (see 'reduce'). It must be associative and
+				commutative.
+	 \param depth The largest number of levels of processors sending their data in the tree
+				(1 : all the processors send their data directly to the master).
+	 \return A ReducedData<T> object on each processor in the program. Only the ReducedData object
+			on the master node will actually contain the result of the reduction, the rest will be empty.
+	*/
+	template<typename F>
+	ReducedData<T> treeAggregate(F func, int depth = 2){
+		InPlaceCombiner<T, F> merge(func);
+		T tmpData = mergePartitions(merge);
+
+		Reduction::karyTree(tmpData, merge, Reduction::fanin(nProcs, depth), MPI_COMM_WORLD, masterProc, Reduction::nextTag());
+
+		ReducedData<T> result(procRank, masterProc);
+		if (procRank==masterProc)
+			result.setData(std::move(tmpData));
+
+		return result;
+	}
+
+	// Overloads for pointers to functions (see 'reduce').
+	ReducedData<T> treeAggregate(T (*func)(T&,T&), int depth = 2){
+		return treeAggregate<T (*)(T&,T&)>(func, depth);
+	}
+
+	ReducedData<T> treeAggregate(void (*func)(T&,T&&), int depth = 2){
+		return treeAggregate<void (*)(T&,T&&)>(func, depth);
+	}
+
+	/**
+	 \brief This method reduces containers (maps, sets, vectors...) like 'reduce', but each
+			container is sent in segments of 'segmentElements' elements, which are streamed to
+			the receiver and combined with its data one after the other. The transfer of a
+			segment overlaps the serialization of the next one, and a processor never holds
+			more than two serialized segments, instead of the whole serialized container.
+	 \param func The function combining two containers (see 'reduce'). It must be associative and
+				commutative, and combining a container with the segments of another one must
+				give the same result as combining it with the whole container (as for the union
+				of sets or the merging of word counts). An in-place combiner is best suited, as
+				the accumulated container is then not copied for each segment.
+	 \param segmentElements The number of elements of the containers in each segment.
+	 \return A ReducedData<T> object on each processor in the program. Only the ReducedData object
+			on the master node will actually contain the result of the reduction, the rest will be empty.
+	*/
+	template<typename F>
+	ReducedData<T> reduceSegmented(F func, std::size_t segmentElements = 64*1024){
+		InPlaceCombiner<T, F> merge(func);
+		T tmpData = mergePartitions(merge);
+
+		Reduction::reduceSegmented(tmpData, merge, segmentElements, masterProc);
+
+		ReducedData<T> result(procRank, masterProc);
+		if (procRank==masterProc)
+			result.setData(std::move(tmpData));
+
+		return result;
+	}
+
+	// Overloads for pointers to functions (see 'reduce').
+	ReducedData<T> reduceSegmented(T (*func)(T&,T&), std::size_t segmentElements = 64*1024){
+		return reduceSegmented<T (*)(T&,T&)>(func, segmentElements);
+	}
+
+	ReducedData<T> reduceSegmented(void (*func)(T&,T&&), std::size_t segmentElements = 64*1024){
+		return reduceSegmented<void (*)(T&,T&&)>(func, segmentElements);
+	}
+
+	/**
+	 \brief This method starts the reduction of the data distributed in a set of DistributedData
+			objects like 'reduce', but returns without waiting for it to be complete, so that
+			other computations can be done while the data is transferred. Numbers combined with
+			a standard operation are reduced with MPI_Ireduce.
+	 \param func The function combining the data (see 'reduce'). It must be associative and
+				commutative.
+	 \return A PendingReduce<T> object, whose 'test' method makes the reduction progress and
+			whose 'wait' method returns the result (on the master node) once it is complete.
+	*/
+	template<typename F>
+	PendingReduce<T> reduceAsync(F func){
+		InPlaceCombiner<T, F> merge(func);
+		T tmpData = mergePartitions(merge);
+
+		if constexpr (NativeOp<F, T>::value)
+			return PendingReduce<T>::start(procRank, masterProc, std::move(tmpData), mpi_type<T>::get(), NativeOp<F, T>::op());
+		else
+			return PendingReduce<T>::start(procRank, masterProc, std::move(tmpData), merge);
+	}
+
+	// Overloads for pointers to functions (see 'reduce').
+	PendingReduce<T> reduceAsync(T (*func)(T&,T&)){
+		return reduceAsync<T (*)(T&,T&)>(func);
+	}
+
+	PendingReduce<T> reduceAsync(void (*func)(T&,T&&)){
+		return reduceAsync<void (*)(T&,T&&)>(func);
+	}
+
+	/**
+	 \brief This method reduces the data distributed in a set of DistributedData objects like
+			'reduce', but the result is returned on all the processors instead of the master only.
+			The reduction is done by recursive doubling : at each of the log2(nProcs) steps,
+			every processor exchanges its partial result with a partner and combines both, so all
+			the processors end up with the same result without any final broadcast. When the
+			number of processors isn't a power of two, the extra processors first give their data
+			to a neighbour and receive the result from it at the end.
+			When T is bitwise copyable, the reduction is done by MPI_Allreduce.
+	 \param func The function combining the data (see 'reduce'). It must be associative and
+				commutative.
+	 \return A ReducedData<T> object on each processor in the program, all containing the result
+			of the reduction.
+	*/
+	template<typename F>
+	ReducedData<T> allReduce(F func){
+		InPlaceCombiner<T, F> merge(func);
+		T tmpData = mergePartitions(merge);
+
+		if constexpr (NativeOp<F, T>::value){
+			T reducedData = T();
+			MPI_Allreduce(&tmpData, &reducedData, 1, mpi_type<T>::get(), NativeOp<F, T>::op(), MPI_COMM_WORLD);
+			tmpData = reducedData;
+		}
+		else if constexpr (bitwise_copyable<T>::value){
+			UserOp<T> userOp(merge);
+			T reducedData(tmpData);
+			MPI_Allreduce(&tmpData, &reducedData, 1, userOp.getType(), userOp.getOp(), MPI_COMM_WORLD);
+			tmpData = reducedData;
+		}
+		else {
+			// 'pof2' is the largest power of two not greater than the number of processors.
+			// The 'rem' first pairs of processors are merged before the exchanges : the even
+			// processor of each pair sends its data to the odd one and waits for the result.
+			int pof2 = 1;
+			while (pof2*2 <= nProcs)
+				pof2 *= 2;
+			int rem = nProcs-pof2;
+
+			int virtualRank;
+			if (procRank < 2*rem){
+				if (procRank%2 == 0){
+					MPI_SendRecv::send(tmpData, procRank+1, 0, MPI_COMM_WORLD);
+					virtualRank = -1;
+				}
+				else {
+					T recvData;
+					MPI_SendRecv::recv(recvData, procRank-1, 0, MPI_COMM_WORLD);
+					merge(recvData, std::move(tmpData));
+					tmpData = std::move(recvData);
+					virtualRank = procRank/2;
+				}
 			}
-			// A processor is a receiver as long as its rank is smaller than half the number
-			// of active processors. Receivers apply 'func' on their data and the received one, 
-			// and then send the result when they become senders.
-			else if (procRank < receivers){
-				if (nb_recv_odd==0 || (nb_recv_odd!=0 && procRank < receivers-1)){
-					T recvData; // Container for the data received during the reduction.
-					MPI_SendRecv::recv(recvData, procRank+receivers, 0, MPI_COMM_WORLD);
-					tmpData = func(tmpData, recvData);
+			else
+				virtualRank = procRank-rem;
+
+			if (virtualRank != -1){
+				for (int mask = 1; mask < pof2; mask *= 2){
+					int virtualPartner = virtualRank^mask;
+					int partner = virtualPartner < rem ? virtualPartner*2+1 : virtualPartner+rem;
+
+					T recvData;
+					MPI_SendRecv::sendrecv(tmpData, partner, recvData, partner, 0, MPI_COMM_WORLD);
+					// Both partners combine the data in the order of their ranks, so that they
+					// compute exactly the same result.
+					if (partner < procRank){
+						merge(recvData, std::move(tmpData));
+						tmpData = std::move(recvData);
+					}
+					else
+						merge(tmpData, std::move(recvData));
 				}
 			}
-		
-			// At every iteration, half the processor have sent their data and become
-			// inactive. The variable 'nb_recv_odd' is used to determine whether there
-			// will be an odd number of receivers at the next iteration. If so, the last of
-			// the receivers won't receive anything during the next step.
-			activeProcs = (activeProcs+1)/2;
-			receivers = (activeProcs+1)/2;
-			nb_recv_odd = activeProcs%2;
-		}
-		
-		// Only the master node of the program has data in the ReducedData object it 
-		// returns. All the other nodes return empty ReducedData objects.
+
+			if (procRank < 2*rem){
+				if (procRank%2 == 0)
+					MPI_SendRecv::recv(tmpData, procRank+1, 0, MPI_COMM_WORLD);
+				else
+					MPI_SendRecv::send(tmpData, procRank-1, 0, MPI_COMM_WORLD);
+			}
+		}
+
 		ReducedData<T> result(procRank, masterProc);
-		if (procRank==0)
-			result.setData(tmpData);
-		
+		result.setData(std::move(tmpData));
+
 		return result;
 	}
+
+	// Overloads for pointers to functions (see 'reduce').
+	ReducedData<T> allReduce(T (*func)(T&,T&)){
+		return allReduce<T (*)(T&,T&)>(func);
+	}
+
+	ReducedData<T> allReduce(void (*func)(T&,T&&)){
+		return allReduce<void (*)(T&,T&&)>(func);
+	}
+
+	/**
+	 \brief This method computes the inclusive prefix scan of the data distributed in a set of
+			DistributedData objects : each partition is replaced by the combination of all the
+			partitions up to it (itself included), in the order of the ranks of the processors
+			and of the partitions on each processor. For example, with std::plus, the partitions
+			contain running totals. Numbers combined with a standard operation and trivially
+			copyable types are scanned by MPI_Exscan, the other types along log2(nProcs) steps
+			of exchanges (see 'Reduction::exscan').
+	 \param func The function combining the data (see 'reduce'). It must be associative, but not
+				necessarily commutative.
+	 \return A new DistributedData<T> object with the same partitions as this one, containing
+			the prefixes.
+	*/
+	template<typename F>
+	DistributedData<T> scan(F func){
+		DistributedData<T> result(procRank, nProcs, masterProc, prefixes(func, true));
+		return result;
+	}
+
+	/**
+	 \brief This method computes the exclusive prefix scan of the data distributed in a set of
+			DistributedData objects : like 'scan', but each partition is replaced by the
+			combination of the partitions before it, without itself. The first partition of
+			processor 0 contains T(). For example, with std::plus and the number of records of
+			each partition, the partitions contain the global index of their first record.
+	 \param func The function combining the data (see 'reduce'). It must be associative, but not
+				necessarily commutative.
+	 \return A new DistributedData<T> object with the same partitions as this one, containing
+			the prefixes.
+	*/
+	template<typename F>
+	DistributedData<T> exscan(F func){
+		DistributedData<T> result(procRank, nProcs, masterProc, prefixes(func, false));
+		return result;
+	}
+
+	// Overloads for pointers to functions (see 'reduce').
+	DistributedData<T> scan(T (*func)(T&,T&)){
+		return scan<T (*)(T&,T&)>(func);
+	}
+
+	DistributedData<T> scan(void (*func)(T&,T&&)){
+		return scan<void (*)(T&,T&&)>(func);
+	}
+
+	DistributedData<T> exscan(T (*func)(T&,T&)){
+		return exscan<T (*)(T&,T&)>(func);
+	}
+
+	DistributedData<T> exscan(void (*func)(T&,T&&)){
+		return exscan<void (*)(T&,T&&)>(func);
+	}
+
+	/**
+	 \brief This method writes the records contained in the DistributedData objects on all
+			processors in a single binary file, in the order of the ranks of the processors
+			(and of the partitions on each processor).
+			All the processors write their records in parallel, at an offset computed from
+			the number of records of the processors before them. It can only be called on
+			DistributedData objects containing a vector of trivially copyable records, and
+			the file it writes can be read back with 'MPI_Context::binaryFile'.
+	 \param filename The name (path) of the file to write. It is replaced if it already exists.
+	*/
+	void saveAsBinaryFile(std::string const& filename){
+		typedef typename T::value_type Record;
+		static_assert(std::is_trivially_copyable<Record>::value, "saveAsBinaryFile can only write trivially copyable records.");
+
+		// The offset of each processor is the number of records on the processors before it.
+		// The records of its partitions are written one after the other.
+		long long count = 0;
+		std::vector<std::pair<const void*, std::size_t>> blocks;
+		for (auto const& partition : partitions){
+			count += partition.size();
+			blocks.emplace_back(partition.data(), partition.size()*sizeof(Record));
+		}
+		long long first = 0;
+		MPI_Exscan(&count, &first, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+		if (procRank == 0)
+			first = 0;
+
+		MPI_File binaryfile;
+		int fileOpened = IOOptions::openFile(MPI_COMM_WORLD, filename.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, &binaryfile);
+
+		if (fileOpened != MPI_SUCCESS){
+			throw FileError();
+		}
+		MPI_File_set_size(binaryfile, 0);
+
+		// All the partitions are written in a single collective call, with a datatype
+		// describing their locations in memory.
+		MPI_Datatype chunkType = MPI_Types::blocks(blocks);
+		MPI_File_write_at_all(binaryfile, first*sizeof(Record), MPI_BOTTOM, 1, chunkType, MPI_STATUS_IGNORE);
+		MPI_Type_free(&chunkType);
+		MPI_File_close(&binaryfile);
+	}
+
+	/**
+	 \brief This method writes the data contained in the DistributedData objects on all processors
+			in text form. Each processor formats its partitions with 'formatter', and all the processors
+			then write their text in parallel, either in a single file (in the order of their ranks,
+			at an offset computed from the size of the text of the processors before them), or each
+			in its own 'part-NNNNN' file of a directory.
+	 \param filename The name (path) of the file to write, or of the directory in which the
+			part files are written. A file is replaced if it already exists.
+	 \param formatter A pointer to a function taking the data of type T as input and returning
+			its text representation.
+	 \param partFiles Whether each processor writes its own file 'filename/part-NNNNN' (where
+			NNNNN is its rank) instead of all processors writing in a single file. The part
+			files already in the directory are removed first.
+	*/
+	void saveAsTextFile(std::string const& filename, std::string (*formatter)(T&), bool partFiles = false){
+		// The text of a processor is the text of its partitions, one after the other.
+		std::string text;
+		for (auto& partition : partitions)
+			text.append(formatter(partition));
+
+		MPI_File textfile;
+		int fileOpened;
+		long long first = 0;
+
+		if (partFiles){
+			// The directory is created by a single processor before the others
+			// open their file in it. The part files left by an earlier save, possibly
+			// from more processors, are removed so that they aren't read with the new ones.
+			if (procRank == masterProc){
+				std::error_code error;
+				std::filesystem::create_directories(filename, error);
+				for (std::filesystem::directory_iterator it(filename, error), last; !error && it != last; it.increment(error))
+					if (it->path().filename().string().rfind("part-", 0) == 0)
+						std::filesystem::remove(it->path(), error);
+			}
+			MPI_Barrier(MPI_COMM_WORLD);
+
+			char partName[32];
+			std::snprintf(partName, sizeof(partName), "/part-%05d", procRank);
+			std::string partPath = filename+partName;
+			fileOpened = IOOptions::openFile(MPI_COMM_SELF, partPath.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, &textfile);
+		}
+		else {
+			// The offset of each processor is the size of the text of the processors before it.
+			long long size = text.size();
+			MPI_Exscan(&size, &first, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+			if (procRank == 0)
+				first = 0;
+
+			fileOpened = IOOptions::openFile(MPI_COMM_WORLD, filename.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, &textfile);
+		}
+
+		if (fileOpened != MPI_SUCCESS){
+			throw FileError();
+		}
+		MPI_File_set_size(textfile, 0);
+
+		MPI_Datatype textType = MPI_Types::bytes(text.size());
+		if (partFiles)
+			MPI_File_write_at(textfile, 0, text.data(), 1, textType, MPI_STATUS_IGNORE);
+		else
+			MPI_File_write_at_all(textfile, first, text.data(), 1, textType, MPI_STATUS_IGNORE);
+		MPI_Type_free(&textType);
+		MPI_File_close(&textfile);
+
+		// Closing a part file only involves its processor, so the processors wait for each
+		// other to have written their file before the directory can be read.
+		if (partFiles)
+			MPI_Barrier(MPI_COMM_WORLD);
+	}
 };
 
 #endif
\ No newline at end of file
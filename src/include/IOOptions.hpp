@@ -0,0 +1,135 @@
+#ifndef __IOOPTIONS_H__
+#define __IOOPTIONS_H__
+
+#include <map>
+#include <string>
+#include <cstdlib>
+#include "mpi.h"
+
+class IOOptions
+{
+	private :
+
+	// The MPI-IO hints, by name.
+	std::map<std::string, std::string> hints;
+
+	public :
+
+	/**
+	 \brief This method enables or disables collective buffering (two-phase I/O) for the
+			collective reads and writes of the files.
+	*/
+	IOOptions& setCollectiveBuffering(bool enable){
+		hints["romio_cb_read"] = enable ? "enable" : "disable";
+		hints["romio_cb_write"] = enable ? "enable" : "disable";
+		return *this;
+	}
+
+	/**
+	 \brief This method sets the number of processors performing the actual I/O when
+			collective buffering is used ('cb_nodes' hint).
+	*/
+	IOOptions& setCbNodes(int nodes){
+		hints["cb_nodes"] = std::to_string(nodes);
+		return *this;
+	}
+
+	/**
+	 \brief This method sets the size in bytes of the buffers used by collective buffering
+			on each I/O processor ('cb_buffer_size' hint).
+	*/
+	IOOptions& setCbBufferSize(long long size){
+		hints["cb_buffer_size"] = std::to_string(size);
+		return *this;
+	}
+
+	/**
+	 \brief This method sets the striping of the files created by the program on parallel file
+			systems such as Lustre : the number of storage targets ('striping_factor' hint) and
+			the size in bytes of a stripe ('striping_unit' hint).
+	*/
+	IOOptions& setStriping(int factor, long long unit){
+		hints["striping_factor"] = std::to_string(factor);
+		hints["striping_unit"] = std::to_string(unit);
+		return *this;
+	}
+
+	/**
+	 \brief This method enables or disables data sieving for the independent reads of the
+			files ('romio_ds_read' hint).
+	*/
+	IOOptions& setDataSieving(bool enable){
+		hints["romio_ds_read"] = enable ? "enable" : "disable";
+		return *this;
+	}
+
+	/**
+	 \brief This method sets any other MPI-IO hint supported by the MPI implementation.
+	 \param key The name of the hint.
+	 \param value The value of the hint.
+	*/
+	IOOptions& setHint(std::string const& key, std::string const& value){
+		hints[key] = value;
+		return *this;
+	}
+
+	std::map<std::string, std::string> const& getHints() const {
+		return hints;
+	}
+
+	/**
+	 \brief This method overrides the hints with the ones defined in the MPICAPSULE_IO_HINTS
+			environment variable, as a comma separated list of 'key=value' pairs (for example
+			MPICAPSULE_IO_HINTS="cb_nodes=8,romio_cb_read=enable").
+	*/
+	void loadEnvironment(){
+		const char* env = std::getenv("MPICAPSULE_IO_HINTS");
+		if (env == nullptr)
+			return;
+
+		std::string list(env);
+		std::size_t pos = 0;
+		while (pos < list.size()){
+			std::size_t next = list.find(',', pos);
+			if (next == std::string::npos)
+				next = list.size();
+
+			std::string hint = list.substr(pos, next-pos);
+			std::size_t equal = hint.find('=');
+			if (equal != std::string::npos && equal > 0)
+				hints[hint.substr(0, equal)] = hint.substr(equal+1);
+
+			pos = next+1;
+		}
+	}
+
+	/**
+	 \brief This method returns the options used for all the files opened by MPICapsule
+			(see 'MPI_Context::setIOOptions').
+	*/
+	static IOOptions& current(){
+		static IOOptions options;
+		return options;
+	}
+
+	/**
+	 \brief This method opens a file like MPI_File_open, with the hints of the current options.
+	 \return The error code returned by MPI_File_open.
+	*/
+	static int openFile(MPI_Comm comm, const char* filename, int amode, MPI_File* file){
+		std::map<std::string, std::string> const& currentHints = current().getHints();
+		if (currentHints.empty())
+			return MPI_File_open(comm, filename, amode, MPI_INFO_NULL, file);
+
+		MPI_Info info;
+		MPI_Info_create(&info);
+		for (auto const& hint : currentHints)
+			MPI_Info_set(info, hint.first.c_str(), hint.second.c_str());
+
+		int result = MPI_File_open(comm, filename, amode, info, file);
+		MPI_Info_free(&info);
+		return result;
+	}
+};
+
+#endif
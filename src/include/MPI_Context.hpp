@@ -5,10 +5,20 @@
 #include <string>
 #include <sstream>
 #include <vector>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include <filesystem>
+#include <glob.h>
 #include "mpi.h"
 #include "DistributedData.hpp"
 #include "MPI_SendRecv.hpp"
+#include "MPI_Types.hpp"
 #include "FileError.hpp"
+#include "IOOptions.hpp"
+#include "ReduceOptions.hpp"
+#include "CompressionOptions.hpp"
+#include "TextPartition.hpp"
 
 class MPI_Context
 {
@@ -20,6 +30,9 @@ class MPI_Context
 
 	public :
 
+	// Default size of the windows read by 'streamTextFile' (64 MB).
+	static const int defaultWindowSize = 64*1024*1024;
+
 	/**
 	 * \brief This constuctor initializes MPI at the beginning of a MPICapsule program :
 				any program using MPICapsule must instantiate a MPI_Context object at its
@@ -33,6 +46,9 @@ class MPI_Context
 		MPI_Init(&argc, &argv);
 		MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 		MPI_Comm_size(MPI_COMM_WORLD, &nProc);
+		IOOptions::current().loadEnvironment();
+		ReduceOptions::current().loadEnvironment();
+		CompressionOptions::current().loadEnvironment();
 	}
 
 	/**
@@ -51,6 +67,9 @@ class MPI_Context
 		MPI_Init(&argc, &argv);
 		MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 		MPI_Comm_size(MPI_COMM_WORLD, &nProc);
+		IOOptions::current().loadEnvironment();
+		ReduceOptions::current().loadEnvironment();
+		CompressionOptions::current().loadEnvironment();
 	}
 
 	int getNProc() const {
@@ -69,19 +88,69 @@ class MPI_Context
 		master = masterRank;
 	}
 
+	/**
+	 * \brief This method sets the MPI-IO hints used for all the files opened by the program
+				(both by the methods of MPI_Context and by the writers of DistributedData). The
+				hints defined in the MPICAPSULE_IO_HINTS environment variable override the ones
+				of 'options' (see 'IOOptions::loadEnvironment').
+	 * \param options An IOOptions object containing the hints.
+	*/
+	void setIOOptions(IOOptions const& options){
+		IOOptions::current() = options;
+		IOOptions::current().loadEnvironment();
+	}
+
+	IOOptions const& getIOOptions() const {
+		return IOOptions::current();
+	}
+
+	/**
+	 * \brief This method sets the options choosing the algorithms of the reductions of serialized
+				data. The options defined in the environment take precedence over the ones
+				of 'options' (see 'ReduceOptions::loadEnvironment').
+	 * \param options A ReduceOptions object.
+	*/
+	void setReduceOptions(ReduceOptions const& options){
+		ReduceOptions::current() = options;
+		ReduceOptions::current().loadEnvironment();
+	}
+
+	ReduceOptions const& getReduceOptions() const {
+		return ReduceOptions::current();
+	}
+
+	/**
+	 * \brief This method sets the options of the compression of the serialized data sent between
+				the processors (by the reductions, or by MPI_SendRecv). The options defined in
+				the environment take precedence over the ones of 'options' (see
+				'CompressionOptions::loadEnvironment').
+	 * \param options A CompressionOptions object.
+	*/
+	void setCompressionOptions(CompressionOptions const& options){
+		CompressionOptions::current() = options;
+		CompressionOptions::current().loadEnvironment();
+	}
+
+	CompressionOptions const& getCompressionOptions() const {
+		return CompressionOptions::current();
+	}
+
 	/**
 	* \brief This method opens a file in parallel on all the processors of the program and loads in a
 				string on each one of them a chunk of the file, for posterior treatment in parallel
 				(distribution of the file).
  	* \param filename The name (path) of the file to distribute.
 	* \param delimiter A character indicating the delimiter that can be used to separate the file in partitions.
+	* \param partitionsPerRank The number of partitions in which the chunk of each processor is divided.
+				Using several partitions per processor allows to move some of them between the
+				processors (see 'DistributedData::rebalance').
  	* \return A DistributedData<std::string> object on each node of the program containing a partition of
-				the file that needed to be distributed.
+				the file that needed to be distributed (or 'partitionsPerRank' consecutive partitions).
 	*/
-	DistributedData<std::string> textFile(char* filename, char delimiter) {
+	DistributedData<std::string> textFile(char* filename, char delimiter, int partitionsPerRank = 1) {
 		// The file is opened on all processors in parallel.
 		MPI_File textfile;
-		int fileOpened = MPI_File_open(MPI_COMM_WORLD, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &textfile);
+		int fileOpened = IOOptions::openFile(MPI_COMM_WORLD, filename, MPI_MODE_RDONLY, &textfile);
 
 		if (fileOpened != MPI_SUCCESS){
 			// If the file entered as parameter can't be opened, an error is
@@ -93,54 +162,351 @@ class MPI_Context
 		MPI_Offset filesize;
 		MPI_File_get_size(textfile, &filesize);
 
-		// Each processor computes the size of the part of the file
-		// it will locally process.
-	 	MPI_Offset localsize = filesize/nProc;
-		// Processors determine the starting and ending points of their part in the file.
-		MPI_Offset start = rank*localsize;
-		MPI_Offset end = start+localsize-1;
+		if (partitionsPerRank < 1)
+			partitionsPerRank = 1;
+		MPI_Offset nPartitions = (MPI_Offset)nProc*partitionsPerRank;
+
+		// Each processor computes the size of the partitions of the file.
+	 	MPI_Offset localsize = filesize/nPartitions;
+		// Processors determine the starting and ending points of each of their partitions in the
+		// file : partition 'i' goes from 'limits[i]' to 'limits[i+1]', the offset right after
+		// its last byte.
+		std::vector<MPI_Offset> limits(partitionsPerRank+1);
+		for (int i = 0; i <= partitionsPerRank; ++i){
+			MPI_Offset partition = (MPI_Offset)rank*partitionsPerRank+i;
+			// The last partition finishes at the end of the file.
+			limits[i] = (partition == nPartitions) ? filesize : partition*localsize;
+
+			// The limits are moved forward to the beginning of the next record, by reading a few
+			// bytes past them until a delimiter is found. Every record then belongs to the partition
+			// containing its first byte, even when it is longer than a partition, and no data has
+			// to be exchanged between the processors.
+			limits[i] = findRecordStart(textfile, limits[i], filesize, delimiter);
+		}
+
+		// Processors all read their respective chunk of the file directly in the local
+		// std::strings of its partitions, in a single collective read. The chunk is read as
+		// one element of a datatype describing the buffers of the strings, since its size
+		// may not fit in an int.
+		std::vector<std::string> localStrings(partitionsPerRank);
+		std::vector<std::pair<const void*, std::size_t>> buffers;
+		for (int i = 0; i < partitionsPerRank; ++i){
+			localStrings[i].resize(limits[i+1]-limits[i]);
+			buffers.emplace_back(localStrings[i].data(), localStrings[i].size());
+		}
+		MPI_Datatype chunkType = MPI_Types::blocks(buffers);
+		MPI_File_read_at_all(textfile, limits[0], MPI_BOTTOM, 1, chunkType, MPI_STATUS_IGNORE);
+		MPI_Type_free(&chunkType);
+		MPI_File_close(&textfile);
+
+		DistributedData<std::string> data(getRank(), getNProc(), getMaster(), std::move(localStrings));
+		return data;
+	}
+
+	/**
+	* \brief This method distributes a file over the processors of the program like 'textFile', but
+				without ever loading a processor's whole chunk of the file in memory : the chunk is
+				read in windows of at most 'windowSize' bytes, and 'func' is applied on the records
+				of each window as soon as it has been read. The results obtained on the successive
+				windows are merged with 'combine'.
+	* \param filename The name (path) of the file to distribute.
+	* \param delimiter A character indicating the delimiter that can be used to separate the file in partitions.
+	* \param func A pointer to a function applied on each window of the file. The string it receives
+				always contains complete records (a record cut by the end of a window is carried
+				over to the next one).
+	* \param combine A pointer to a function merging the results of 'func' on two windows.
+	* \param windowSize The maximal number of bytes read from the file at once by each processor.
+	* \param prefetch The number of windows read in advance with non-blocking reads while 'func' is
+				applied on the current one (2 for double buffering, 3 for triple buffering...).
+				The memory used by each processor is about 'prefetch'+1 windows.
+	* \return A DistributedData<R> object on each node of the program containing the combined results
+				of 'func' on its chunk of the file.
+	*/
+	template<typename R>
+	DistributedData<R> streamTextFile(char* filename, char delimiter, R (*func)(std::string&),
+	                                  R (*combine)(R&,R&), int windowSize = defaultWindowSize, int prefetch = 2) {
+		MPI_File textfile;
+		int fileOpened = IOOptions::openFile(MPI_COMM_WORLD, filename, MPI_MODE_RDONLY, &textfile);
+
+		if (fileOpened != MPI_SUCCESS){
+			throw FileError();
+		}
 
-		// The last processor finishes at the end of the file.
+		MPI_Offset filesize;
+		MPI_File_get_size(textfile, &filesize);
+
+		// The chunks are computed as in 'textFile'.
+		MPI_Offset localsize = filesize/nProc;
+		MPI_Offset start = rank*localsize;
+		MPI_Offset end = start+localsize;
 		if (rank == nProc-1)
 			end = filesize;
-		// localsize is recomputed to take into account the potential difference of size for the
-		// last processor's chunk.
-		localsize = end-start+1;
-
-		// Memory allocation of a C string.
-		char *chunk = (char*)malloc((localsize+1)*sizeof(char));
-		// Processors all read their respective chunk of the file.
-		MPI_File_read_at_all(textfile, start, chunk, localsize, MPI_CHAR, MPI_STATUS_IGNORE);
-		chunk[localsize] = '\0';
+		start = findRecordStart(textfile, start, filesize, delimiter);
+		end = findRecordStart(textfile, end, filesize, delimiter);
+
+		// 'window' always holds the records that haven't been processed yet : it starts with the
+		// incomplete record carried over from the previous window (if any), followed by the bytes
+		// that have just been read.
+		std::string window;
+
+		// The windows are read in a ring of 'prefetch' buffers : as soon as a window has been
+		// read and copied in 'window', the read of a new window is started in its buffer, and
+		// runs while 'func' is applied on the records.
+		if (prefetch < 1)
+			prefetch = 1;
+		std::vector<std::string> buffers(prefetch);
+		std::vector<MPI_Request> requests(prefetch, MPI_REQUEST_NULL);
+		MPI_Offset next = start;
+		auto startRead = [&](int slot){
+			int count = (end-next < windowSize) ? (int)(end-next) : windowSize;
+			buffers[slot].resize(count);
+			MPI_File_iread_at(textfile, next, &buffers[slot][0], count, MPI_CHAR, &requests[slot]);
+			next += count;
+		};
+		for (int slot = 0; slot < prefetch && next < end; ++slot)
+			startRead(slot);
+
+		R result = R();
+		bool hasResult = false;
+		std::string carry;
+
+		for (int slot = 0; requests[slot] != MPI_REQUEST_NULL; slot = (slot+1)%prefetch){
+			MPI_Status status;
+			MPI_Wait(&requests[slot], &status);
+			int read;
+			MPI_Get_count(&status, MPI_CHAR, &read);
+			window.append(buffers[slot], 0, read);
+
+			if (next < end)
+				startRead(slot);
+
+			// Only the complete records of the window are processed, the rest is kept for
+			// the next window.
+			std::size_t delim_pos = window.rfind(delimiter);
+			if (delim_pos == std::string::npos)
+				continue;
+			carry.assign(window, delim_pos+1, std::string::npos);
+			window.resize(delim_pos+1);
+
+			R partial = func(window);
+			result = hasResult ? combine(result, partial) : partial;
+			hasResult = true;
+
+			// Assigning (rather than swapping) keeps the capacity of 'window', so that
+			// the memory used for one window is reused for the next ones.
+			window.assign(carry);
+		}
 		MPI_File_close(&textfile);
 
-		// The chunk of the file to be locally processed by each processor is copied in a
-		// local std::string.
-		std::string localString = chunk;
-		free(chunk);
+		// The chunk ends after a delimiter (or at the end of the file), so what remains in
+		// the window are complete records.
+		if (!window.empty() || !hasResult){
+			R partial = func(window);
+			result = hasResult ? combine(result, partial) : partial;
+		}
+
+		DistributedData<R> data(getRank(), getNProc(), getMaster(), std::move(result));
+		return data;
+	}
+
+	/**
+	* \brief This method distributes a file over the processors of the program without copying it :
+				each processor maps its chunk of the file in memory and gets a TextPartition giving
+				access to its records through std::string_view objects. The chunks always start
+				at the beginning of a record and end after the delimiter of their last record.
+	* \param filename The name (path) of the file to distribute.
+	* \param delimiter A character indicating the delimiter separating the records of the file.
+	* \return A DistributedData<TextPartition> object on each node of the program containing its
+				partition of the file.
+	*/
+	DistributedData<TextPartition> textPartition(char* filename, char delimiter) {
+		MPI_File textfile;
+		int fileOpened = IOOptions::openFile(MPI_COMM_WORLD, filename, MPI_MODE_RDONLY, &textfile);
+
+		if (fileOpened != MPI_SUCCESS){
+			throw FileError();
+		}
+
+		MPI_Offset filesize;
+		MPI_File_get_size(textfile, &filesize);
+
+		// The nominal chunks are the same as in 'textFile'. Each of their limits is then moved
+		// forward to the beginning of the next record, so that every record belongs to the
+		// processor whose nominal chunk contains its first byte.
+		MPI_Offset localsize = filesize/nProc;
+		MPI_Offset start = rank*localsize;
+		MPI_Offset end = (rank == nProc-1) ? filesize : start+localsize;
+
+		MPI_Offset begin = findRecordStart(textfile, start, filesize, delimiter);
+		end = findRecordStart(textfile, end, filesize, delimiter);
+		MPI_File_close(&textfile);
+
+		TextPartition partition = TextPartition::load(filename, begin, end, delimiter);
+
+		DistributedData<TextPartition> data(getRank(), getNProc(), getMaster(), std::move(partition));
+		return data;
+	}
+
+	/**
+	* \brief This method distributes a set of files over the processors of the program, as if they
+				were a single file : the files matching 'pattern' are listed once by the master, and
+				each processor gets the records contained in the same number of bytes of the set,
+				whatever the size of the individual files. A record never spans two files.
+	* \param pattern A shell pattern matching the names (paths) of the files to distribute (for
+				example "logs/part-*.txt").
+	* \param delimiter A character indicating the delimiter separating the records of the files.
+	* \return A DistributedData<std::string> object on each node of the program containing its
+				partition of the files. A delimiter is added after the last record of a file when
+				the file doesn't end with one.
+	*/
+	DistributedData<std::string> textFiles(std::string const& pattern, char delimiter) {
+		std::vector<std::pair<std::string, long long>> files;
+		if (rank == master)
+			files = listFiles(pattern, false);
+		MPI_SendRecv::broadcast(files, master, MPI_COMM_WORLD);
+
+		if (files.empty()){
+			throw FileError();
+		}
+
+		long long totalsize = 0;
+		for (auto const& file : files)
+			totalsize += file.second;
+
+		// The chunks are computed as in 'textFile', but on the concatenation of the files.
+		long long localsize = totalsize/nProc;
+		long long start = rank*localsize;
+		long long end = (rank == nProc-1) ? totalsize : start+localsize;
+
+		std::string localString;
+		long long fileStart = 0;
+		for (auto const& file : files){
+			long long fileEnd = fileStart+file.second;
+
+			if (fileStart < end && fileEnd > start){
+				MPI_File textfile;
+				int fileOpened = IOOptions::openFile(MPI_COMM_SELF, file.first.c_str(), MPI_MODE_RDONLY, &textfile);
 
-		// The first 'word' (first string of characters until the next delimiter) is sent by each processor
-		// of rank higher than 0 to its 'left neighbour' and will then be ignored in the localString.
-		if (rank > 0){
-			std::string first;
-			std::size_t delim_pos = localString.find(delimiter)+1;
-			first = localString.substr(0, delim_pos);
-			MPI_SendRecv::send(first, rank-1, 0, MPI_COMM_WORLD);
+				if (fileOpened != MPI_SUCCESS){
+					throw FileError();
+				}
 
-			// The string read with localString.substr() is not included in the localString
-			// anymore.
-			localString.erase(0, delim_pos);
+				// The part of the chunk in this file has its limits moved to the beginning of the
+				// next record in the file, as in 'textFile'.
+				MPI_Offset begin = findRecordStart(textfile, std::max(start, fileStart)-fileStart, file.second, delimiter);
+				MPI_Offset stop = findRecordStart(textfile, std::min(end, fileEnd)-fileStart, file.second, delimiter);
+
+				readRange(textfile, begin, stop, localString);
+				MPI_File_close(&textfile);
+
+				if (stop > begin && localString.back() != delimiter)
+					localString.push_back(delimiter);
+			}
+
+			fileStart = fileEnd;
 		}
 
-		// The string received from the right neighbour by each proc. is added at the end
-		// of localString (except for the last processor, of rank nProc-1).
-		if (rank < nProc-1){
-			std::string last;
-			MPI_SendRecv::recv(last, rank+1, 0, MPI_COMM_WORLD);
-			localString.append(last);
+		DistributedData<std::string> data(getRank(), getNProc(), getMaster(), std::move(localString));
+		return data;
+	}
+
+	/**
+	* \brief This method distributes the files of a directory over the processors of the program,
+				without splitting them : each file is entirely read by one processor. The files are
+				assigned to the processors so that they all read roughly the same number of bytes
+				(each file, from the largest to the smallest, goes to the least loaded processor).
+	* \param directory The name (path) of the directory containing the files to distribute.
+	* \return A DistributedData object on each node of the program containing a vector of
+				(filename, content) pairs for the files it has read.
+	*/
+	DistributedData<std::vector<std::pair<std::string, std::string>>> wholeTextFiles(std::string const& directory) {
+		std::vector<std::pair<std::string, long long>> files;
+		if (rank == master)
+			files = listFiles(directory, true);
+		MPI_SendRecv::broadcast(files, master, MPI_COMM_WORLD);
+
+		if (files.empty()){
+			throw FileError();
+		}
+
+		// All the processors compute the same assignment from the same listing.
+		std::vector<std::size_t> order(files.size());
+		for (std::size_t i = 0; i < order.size(); ++i)
+			order[i] = i;
+		std::stable_sort(order.begin(), order.end(), [&files](std::size_t a, std::size_t b){
+			return files[a].second > files[b].second;
+		});
+
+		std::vector<long long> load(nProc, 0);
+		std::vector<int> owner(files.size());
+		for (std::size_t i : order){
+			int leastLoaded = std::min_element(load.begin(), load.end())-load.begin();
+			owner[i] = leastLoaded;
+			load[leastLoaded] += files[i].second;
+		}
+
+		std::vector<std::pair<std::string, std::string>> localFiles;
+		for (std::size_t i = 0; i < files.size(); ++i){
+			if (owner[i] != rank)
+				continue;
+
+			MPI_File textfile;
+			int fileOpened = IOOptions::openFile(MPI_COMM_SELF, files[i].first.c_str(), MPI_MODE_RDONLY, &textfile);
+
+			if (fileOpened != MPI_SUCCESS){
+				throw FileError();
+			}
+
+			std::string content;
+			readRange(textfile, 0, files[i].second, content);
+			MPI_File_close(&textfile);
+
+			localFiles.emplace_back(files[i].first, std::move(content));
+		}
+
+		DistributedData<std::vector<std::pair<std::string, std::string>>> data(getRank(), getNProc(), getMaster(), std::move(localFiles));
+		return data;
+	}
+
+	/**
+	* \brief This method distributes a binary file made of fixed-size records of type T over the
+				processors of the program : each processor reads the same number of records (the last
+				one also reads the remaining ones) directly in a vector, without any parsing.
+	* \param filename The name (path) of the file to distribute. Its size should be a multiple of
+				sizeof(T), an incomplete record at the end of the file is ignored.
+	* \return A DistributedData<std::vector<T>> object on each node of the program containing its
+				records of the file.
+	*/
+	template<typename T>
+	DistributedData<std::vector<T>> binaryFile(std::string const& filename) {
+		static_assert(std::is_trivially_copyable<T>::value, "binaryFile can only read trivially copyable records.");
+
+		MPI_File binaryfile;
+		int fileOpened = IOOptions::openFile(MPI_COMM_WORLD, filename.c_str(), MPI_MODE_RDONLY, &binaryfile);
+
+		if (fileOpened != MPI_SUCCESS){
+			throw FileError();
 		}
 
-		DistributedData<std::string> data(getRank(), getNProc(), getMaster(), localString);
+		MPI_Offset filesize;
+		MPI_File_get_size(binaryfile, &filesize);
+
+		// The chunks are computed in numbers of records, so that they are always aligned
+		// on the records of the file.
+		MPI_Offset nRecords = filesize/sizeof(T);
+		MPI_Offset localcount = nRecords/nProc;
+		MPI_Offset first = rank*localcount;
+		if (rank == nProc-1)
+			localcount = nRecords-first;
+
+		std::vector<T> records(localcount);
+
+		MPI_Datatype chunkType = MPI_Types::bytes(localcount*sizeof(T));
+		MPI_File_read_at_all(binaryfile, first*sizeof(T), records.data(), 1, chunkType, MPI_STATUS_IGNORE);
+		MPI_Type_free(&chunkType);
+		MPI_File_close(&binaryfile);
+
+		DistributedData<std::vector<T>> data(getRank(), getNProc(), getMaster(), std::move(records));
 		return data;
 	}
 
@@ -151,6 +517,104 @@ class MPI_Context
 	void finalize() {
 		MPI_Finalize();
 	}
+
+	private :
+
+	/**
+	 * \brief This method lists the regular files matching a shell pattern, or contained in a
+			 directory, in alphabetical order.
+	 * \return A vector of (filename, size) pairs, empty if no file was found.
+	*/
+	static std::vector<std::pair<std::string, long long>> listFiles(std::string const& path, bool directory){
+		std::vector<std::string> names;
+		std::error_code error;
+
+		if (directory){
+			for (std::filesystem::directory_iterator it(path, error), last; !error && it != last; it.increment(error))
+				names.push_back(it->path().string());
+		}
+		else {
+			glob_t matches;
+			if (glob(path.c_str(), 0, nullptr, &matches) == 0){
+				for (std::size_t i = 0; i < matches.gl_pathc; ++i)
+					names.push_back(matches.gl_pathv[i]);
+			}
+			globfree(&matches);
+		}
+		std::sort(names.begin(), names.end());
+
+		std::vector<std::pair<std::string, long long>> files;
+		for (auto const& name : names){
+			if (!std::filesystem::is_regular_file(name, error))
+				continue;
+			std::uintmax_t size = std::filesystem::file_size(name, error);
+			if (!error)
+				files.emplace_back(name, (long long)size);
+		}
+		return files;
+	}
+
+	/**
+	 * \brief This method reads the bytes [begin, end) of a file and appends them to 'out'.
+	*/
+	static void readRange(MPI_File file, MPI_Offset begin, MPI_Offset end, std::string& out){
+		while (begin < end){
+			int read = readWindow(file, begin, end, defaultWindowSize, out);
+			if (read == 0)
+				break;
+			begin += read;
+		}
+	}
+
+	/**
+	 * \brief This method returns the offset of the first record of a file starting at or after
+			 'pos', that is the first offset 'p' >= 'pos' such that 'p' is 0 or the byte at 'p-1'
+			 is a delimiter. The file is read in small windows, starting right before 'pos',
+			 until a delimiter is found.
+	 * \return The offset of the record, or the size of the file if there is none.
+	*/
+	static MPI_Offset findRecordStart(MPI_File file, MPI_Offset pos, MPI_Offset filesize, char delimiter){
+		if (pos <= 0)
+			return 0;
+
+		std::string window;
+		int windowSize = 4096;
+		MPI_Offset offset = pos-1;
+		while (offset < filesize){
+			window.clear();
+			int read = readWindow(file, offset, filesize, windowSize, window);
+			// Nothing more can be read (a read error, or a file shorter than expected).
+			if (read == 0)
+				break;
+			std::size_t delim_pos = window.find(delimiter);
+			if (delim_pos != std::string::npos)
+				return offset+delim_pos+1;
+			offset += read;
+			// Long records are crossed with larger and larger windows.
+			if (windowSize < defaultWindowSize)
+				windowSize *= 2;
+		}
+		return filesize;
+	}
+
+	/**
+	 * \brief This method reads at most 'windowSize' bytes of a file, starting at 'pos' and
+			 without going past 'end', and appends them to 'window'.
+	 * \return The number of bytes actually read.
+	*/
+	static int readWindow(MPI_File file, MPI_Offset pos, MPI_Offset end, int windowSize, std::string& window){
+		int count = (end-pos < windowSize) ? (int)(end-pos) : windowSize;
+		std::size_t oldSize = window.size();
+		window.resize(oldSize+count);
+
+		MPI_Status status;
+		MPI_File_read_at(file, pos, &window[oldSize], count, MPI_CHAR, &status);
+		int read;
+		MPI_Get_count(&status, MPI_CHAR, &read);
+		window.resize(oldSize+read);
+
+		return read;
+	}
 };
 
 #endif
@@ -5,8 +5,13 @@
 #include <vector>
 #include <map>
 #include <unordered_map>
+#include <climits>
+#include <cstring>
 #include "mpi.h"
+#include "MPI_Types.hpp"
 #include "Serialization.hpp"
+#include "Compression.hpp"
+#include "CompressionOptions.hpp"
 
 class MPI_SendRecv
 {
@@ -47,6 +52,14 @@ class MPI_SendRecv
 	*/
 	template<typename T>
 	static void send(T const& data, int dest, int tag, MPI_Comm comm);
+
+	/**
+	 \brief This method sends an STL container like the other 'send' method, but compresses it
+			according to 'compression' instead of the options of the program (see
+			'MPI_Context::setCompressionOptions'). It is received by 'recv' as usual.
+	*/
+	template<typename T>
+	static void send(T const& data, int dest, int tag, MPI_Comm comm, CompressionOptions const& compression);
 	
 	/**
 	 \brief This method allows a processor to receive an STL container of data 
@@ -59,118 +72,314 @@ class MPI_SendRecv
 	template<typename T>
 	static void recv(T& data, int src, int tag, MPI_Comm comm);
 
-};
+	/**
+	 \brief This method broadcasts an STL container of data of type T from the 'root' 
+			processor to all the other processors of the 'comm' communicator. It must 
+			be called by all the processors of the communicator.
+	 \param data The adress of the container to be broadcast on the root, and in which
+			the data must be retrieved on the other processors.
+	 \param root The rank of the processor broadcasting the data.
+	 \param comm MPI communicator on which the data is broadcast.
+	*/
+	template<typename T>
+	static void broadcast(T& data, int root, MPI_Comm comm);
 
-/* Send and receive methods for arrays of basic datatypes. */
+	/**
+	 \brief This method sends an STL container of data of type T to a processor and receives
+			another one from a processor at the same time (the two processors can be the same,
+			as when two processors exchange their data), without risk of deadlock.
+	 \param sendData The adress of the data to be sent.
+	 \param dest The rank of the destination node for the data sent.
+	 \param recvData The adress of the container in which the received data must be retrieved.
+	 \param src The rank of the source node of the data received.
+	 \param tag MPI tag of the messages.
+	 \param comm MPI communicator on which the messages are exchanged.
+	*/
+	template<typename T>
+	static void sendrecv(T const& sendData, int dest, T& recvData, int src, int tag, MPI_Comm comm);
 
-/* char */
-template<>
-void MPI_SendRecv::send(char const& data, int len, int dest, int tag, MPI_Comm comm){
-	MPI_Send(&data, len, MPI_CHAR, dest, tag, comm);
-}
+	/**
+	 \brief This method sends a buffer of bitwise copyable elements (see 'contiguous_trivial')
+			as raw bytes, read directly in its memory, in a single message. The receiver finds
+			its size with MPI_Mprobe (see 'recvBuffer').
+	 \param buffer An std::string or an std::vector of bitwise copyable elements.
+	 \param dest The rank of the destination node for the message.
+	 \param tag MPI tag of the message.
+	 \param comm MPI communicator on which the message must be sent.
+	*/
+	template<typename Buffer>
+	static void sendBuffer(Buffer const& buffer, int dest, int tag, MPI_Comm comm){
+		int count;
+		MPI_Datatype type = bytesType(buffer.size()*sizeof(buffer[0]), count);
+		MPI_Send(buffer.data(), count, type, dest, tag, comm);
+		freeBytesType(type);
+	}
 
-template<>
-void MPI_SendRecv::recv(char& data, int len, int src, int tag, MPI_Comm comm){
-	MPI_Status s;
-	MPI_Recv(&data, len, MPI_CHAR, src, tag, comm, &s);
-}
+	/**
+	 \brief This method receives a buffer sent by 'sendBuffer' directly in 'buffer', which is
+			resized to the number of elements received.
+	*/
+	template<typename Buffer>
+	static void recvBuffer(Buffer& buffer, int src, int tag, MPI_Comm comm){
+		MPI_Message message;
+		MPI_Status status;
+		MPI_Mprobe(src, tag, comm, &message, &status);
+		mrecvBuffer(buffer, message, status);
+	}
 
-/* int */
-template<>
-void MPI_SendRecv::send(int const& data, int len, int dest, int tag, MPI_Comm comm){
-	MPI_Send(&data, len, MPI_INT, dest, tag, comm);
-}
+	/**
+	 \brief This method receives a buffer sent by 'sendBuffer' whose message has already been
+			matched by MPI_Mprobe or MPI_Improbe.
+	 \param message The message matched, MPI_MESSAGE_NULL after the call.
+	 \param status The status returned with the message.
+	*/
+	template<typename Buffer>
+	static void mrecvBuffer(Buffer& buffer, MPI_Message& message, MPI_Status& status){
+		MPI_Count bytes;
+		MPI_Get_elements_x(&status, MPI_CHAR, &bytes);
+		buffer.resize(bytes/sizeof(buffer[0]));
 
-template<>
-void MPI_SendRecv::recv(int& data, int len, int src, int tag, MPI_Comm comm){
-	MPI_Status s;
-	MPI_Recv(&data, len, MPI_INT, src, tag, comm, &s);
-}
+		int count;
+		MPI_Datatype type = bytesType(bytes, count);
+		MPI_Mrecv(buffer.data(), count, type, &message, MPI_STATUS_IGNORE);
+		freeBytesType(type);
+	}
 
-/* float */
-template<>
-void MPI_SendRecv::send(float const& data, int len, int dest, int tag, MPI_Comm comm){
-	MPI_Send(&data, len, MPI_FLOAT, dest, tag, comm);
-}
+	/**
+	 \brief This method broadcasts a buffer of bitwise copyable elements from the 'root'
+			processor, in the same buffer on the other processors. The number of elements
+			is broadcast first, since the other processors can't probe a broadcast.
+	*/
+	template<typename Buffer>
+	static void broadcastBuffer(Buffer& buffer, int root, MPI_Comm comm){
+		unsigned long long len = buffer.size();
+		MPI_Bcast(&len, 1, MPI_UNSIGNED_LONG_LONG, root, comm);
+		buffer.resize(len);
+		if (len == 0)
+			return;
 
-template<>
-void MPI_SendRecv::recv(float& data, int len, int src, int tag, MPI_Comm comm){
-	MPI_Status s;
-	MPI_Recv(&data, len, MPI_FLOAT, src, tag, comm, &s);
-}
+		int count;
+		MPI_Datatype type = bytesType(len*sizeof(buffer[0]), count);
+		MPI_Bcast(buffer.data(), count, type, root, comm);
+		freeBytesType(type);
+	}
 
-/* double */
-template<>
-void MPI_SendRecv::send(double const& data, int len, int dest, int tag, MPI_Comm comm){
-	MPI_Send(&data, len, MPI_DOUBLE, dest, tag, comm);
+	/**
+	 \brief This method sends a buffer of bitwise copyable elements to a processor and receives
+			one from a processor at the same time, directly in 'recvData'.
+	*/
+	template<typename Buffer>
+	static void sendrecvBuffer(Buffer const& sendData, int dest, Buffer& recvData, int src, int tag, MPI_Comm comm){
+		int count;
+		MPI_Datatype type = bytesType(sendData.size()*sizeof(sendData[0]), count);
+		MPI_Request request;
+		MPI_Isend(sendData.data(), count, type, dest, tag, comm, &request);
+		recvBuffer(recvData, src, tag, comm);
+		MPI_Wait(&request, MPI_STATUS_IGNORE);
+		freeBytesType(type);
+	}
+
+	/**
+	 \brief This method receives an STL container sent by 'send' whose message has already been
+			matched by MPI_Mprobe or MPI_Improbe, directly in the memory it is read from.
+	 \param message The message matched, MPI_MESSAGE_NULL after the call.
+	 \param status The status returned with the message.
+	*/
+	template<typename T>
+	static void mrecv(T& data, MPI_Message& message, MPI_Status& status){
+		if constexpr (contiguous_trivial<T>::value)
+			mrecvBuffer(data, message, status);
+		else {
+			std::vector<char> buffer;
+			mrecvBuffer(buffer, message, status);
+			data = unpack<T>(buffer.data(), buffer.size());
+		}
+	}
+
+	/**
+	 \brief This method serializes a container in 'buffer' in the form in which it is sent : the
+			serialized data, compressed when 'compression' applies to its size (and only if it
+			gets smaller), followed by the size of the serialized data (unsigned long long) and
+			a byte of flags telling whether it is compressed.
+	 \param data The container to serialize.
+	 \param buffer The std::vector<char> receiving the data. Its previous content is erased, but
+			its memory is reused.
+	 \param compression The compression options applied to the data.
+	*/
+	template<typename T>
+	static void pack(T const& data, std::vector<char>& buffer, CompressionOptions const& compression = CompressionOptions::current()){
+		buffer.clear();
+		Serialization<T>::serialize(data, buffer);
+
+		unsigned long long rawSize = buffer.size();
+		char flags = 0;
+		if (compression.applies(rawSize)){
+			std::vector<char> compressed;
+			Compression::compress(buffer.data(), rawSize, compressed);
+			if (compressed.size() < rawSize){
+				buffer.swap(compressed);
+				flags |= Compressed;
+			}
+		}
+
+		const char* trailer = reinterpret_cast<const char*>(&rawSize);
+		buffer.insert(buffer.end(), trailer, trailer+sizeof(rawSize));
+		buffer.push_back(flags);
+	}
+
+	/**
+	 \brief This method deserializes a container packed by 'pack', decompressing it if needed.
+	 \param data The address of the packed container.
+	 \param size The size in bytes of the packed container.
+	 \throw CompressionError if the packed data is corrupted.
+	*/
+	template<typename T>
+	static T unpack(const char* data, std::size_t size){
+		unsigned long long rawSize;
+		if (size < sizeof(rawSize)+1)
+			throw CompressionError();
+
+		char flags = data[size-1];
+		std::memcpy(&rawSize, data+size-1-sizeof(rawSize), sizeof(rawSize));
+		size -= sizeof(rawSize)+1;
+		if (!(flags & Compressed))
+			return Serialization<T>::deserialize(data, size);
+
+		std::vector<char> serialized(rawSize);
+		Compression::decompress(data, size, serialized.data(), rawSize);
+		return Serialization<T>::deserialize(serialized.data(), serialized.size());
+	}
+
+	private :
+
+	// The flags of the packed data (see 'pack').
+	static const char Compressed = 1;
+
+	// Returns the datatype and the count transferring 'n' bytes : MPI_CHAR when 'n' fits in
+	// the int count of the MPI functions, one element of a datatype describing them otherwise.
+	static MPI_Datatype bytesType(unsigned long long n, int& count){
+		if (n <= INT_MAX){
+			count = n;
+			return MPI_CHAR;
+		}
+		count = 1;
+		return MPI_Types::bytes(n);
+	}
+
+	static void freeBytesType(MPI_Datatype& type){
+		if (type != MPI_CHAR)
+			MPI_Type_free(&type);
+	}
+
+};
+
+/* Send and receive methods for arrays of values having an MPI datatype (see mpi_type).
+   The arrays of other bitwise copyable values are transferred as raw bytes. */
+template<typename T>
+void MPI_SendRecv::send(T const& data, int len, int dest, int tag, MPI_Comm comm){
+	if constexpr (mpi_type<T>::defined)
+		MPI_Send(&data, len, mpi_type<T>::get(), dest, tag, comm);
+	else {
+		static_assert(bitwise_copyable<T>::value, "Only the arrays of bitwise copyable values can be sent.");
+		MPI_Datatype bytesType = MPI_Types::bytes(len*sizeof(T));
+		MPI_Send(&data, 1, bytesType, dest, tag, comm);
+		MPI_Type_free(&bytesType);
+	}
 }
 
-template<>
-void MPI_SendRecv::recv(double& data, int len, int src, int tag, MPI_Comm comm){
-	MPI_Status s;
-	MPI_Recv(&data, len, MPI_DOUBLE, src, tag, comm, &s);
+template<typename T>
+void MPI_SendRecv::recv(T& data, int len, int src, int tag, MPI_Comm comm){
+	if constexpr (mpi_type<T>::defined)
+		MPI_Recv(&data, len, mpi_type<T>::get(), src, tag, comm, MPI_STATUS_IGNORE);
+	else {
+		static_assert(bitwise_copyable<T>::value, "Only the arrays of bitwise copyable values can be received.");
+		MPI_Datatype bytesType = MPI_Types::bytes(len*sizeof(T));
+		MPI_Recv(&data, 1, bytesType, src, tag, comm, MPI_STATUS_IGNORE);
+		MPI_Type_free(&bytesType);
+	}
 }
 
-/* short */
+/* Send and receive methods for std::string objects. The string is received directly
+   in its own buffer (see 'sendBuffer'). The full specializations are defined inline,
+   since this header is included in every translation unit of a program. */
 template<>
-void MPI_SendRecv::send(short const& data, int len, int dest, int tag, MPI_Comm comm){
-	MPI_Send(&data, len, MPI_LONG, dest, tag, comm);
+inline void MPI_SendRecv::send(std::string const& str, int dest, int tag, MPI_Comm comm){
+	sendBuffer(str, dest, tag, comm);
 }
 
 template<>
-void MPI_SendRecv::recv(short& data, int len, int src, int tag, MPI_Comm comm){
-	MPI_Status s;
-	MPI_Recv(&data, len, MPI_LONG, src, tag, comm, &s);
+inline void MPI_SendRecv::recv(std::string& str, int src, int tag, MPI_Comm comm){
+	recvBuffer(str, src, tag, comm);
 }
 
-/* long */
+/* Broadcast method for std::string objects. */
 template<>
-void MPI_SendRecv::send(long const& data, int len, int dest, int tag, MPI_Comm comm){
-	MPI_Send(&data, len, MPI_LONG, dest, tag, comm);
+inline void MPI_SendRecv::broadcast(std::string& str, int root, MPI_Comm comm){
+	broadcastBuffer(str, root, comm);
 }
 
+/* Exchange method for std::string objects. */
 template<>
-void MPI_SendRecv::recv(long& data, int len, int src, int tag, MPI_Comm comm){
-	MPI_Status s;
-	MPI_Recv(&data, len, MPI_LONG, src, tag, comm, &s);
+inline void MPI_SendRecv::sendrecv(std::string const& sendStr, int dest, std::string& recvStr, int src, int tag, MPI_Comm comm){
+	sendrecvBuffer(sendStr, dest, recvStr, src, tag, comm);
 }
 
-/* Send and receive methods for std::string objects. */
-template<>
-void MPI_SendRecv::send(std::string const& str, int dest, int tag, MPI_Comm comm){
-	unsigned len = str.size();
-	MPI_Send(&len, 1, MPI_UNSIGNED, dest, tag, comm);
-	if (len != 0)
-		MPI_Send(str.data(), len, MPI_CHAR, dest, tag, comm);
+/* Send and receive methods for all std containers (vectors or maps for example). The
+   vectors of bitwise copyable elements are sent as raw bytes, straight from their memory.
+   The other containers are packed (serialized, and compressed if the options allow it) in
+   a vector which is sent as is, and unpacked directly from the vector in which they are
+   received. */
+template<typename T>
+void MPI_SendRecv::send(T const& data, int dest, int tag, MPI_Comm comm){
+	send(data, dest, tag, comm, CompressionOptions::current());
 }
 
-template<>
-void MPI_SendRecv::recv(std::string& str, int src, int tag, MPI_Comm comm){
-	unsigned len;
-	MPI_Status s;
-	MPI_Recv(&len, 1, MPI_UNSIGNED, src, tag, comm, &s);
-
-	if (len != 0){
-		std::vector<char> tmp(len);
-		MPI_Recv(tmp.data(), len, MPI_CHAR, src, tag, comm, &s);
-		str.assign(tmp.begin(), tmp.end());
+template<typename T>
+void MPI_SendRecv::send(T const& data, int dest, int tag, MPI_Comm comm, CompressionOptions const& compression){
+	if constexpr (contiguous_trivial<T>::value)
+		sendBuffer(data, dest, tag, comm);
+	else {
+		std::vector<char> buffer;
+		pack(data, buffer, compression);
+		sendBuffer(buffer, dest, tag, comm);
 	}
-	else
-		str.clear();
 }
 
-/* Send and receive methods for all std containers (vectors or maps for example). */
 template<typename T>
-void MPI_SendRecv::send(T const& data, int dest, int tag, MPI_Comm comm){
-	std::string serializedData = Serialization<T>::serialize(data);
-	send(serializedData, dest, tag, comm);
+void MPI_SendRecv::recv(T& data, int src, int tag, MPI_Comm comm){
+	MPI_Message message;
+	MPI_Status status;
+	MPI_Mprobe(src, tag, comm, &message, &status);
+	mrecv(data, message, status);
 }
 
 template<typename T>
-void MPI_SendRecv::recv(T& data, int src, int tag, MPI_Comm comm){
-	std::string recvStr;
-	recv(recvStr, src, tag, comm);
-	data = Serialization<T>::deserialize(recvStr);
+void MPI_SendRecv::broadcast(T& data, int root, MPI_Comm comm){
+	if constexpr (contiguous_trivial<T>::value)
+		broadcastBuffer(data, root, comm);
+	else {
+		int rank;
+		MPI_Comm_rank(comm, &rank);
+		std::vector<char> buffer;
+		if (rank == root)
+			pack(data, buffer);
+		broadcastBuffer(buffer, root, comm);
+		if (rank != root)
+			data = unpack<T>(buffer.data(), buffer.size());
+	}
+}
+
+template<typename T>
+void MPI_SendRecv::sendrecv(T const& sendData, int dest, T& recvData, int src, int tag, MPI_Comm comm){
+	if constexpr (contiguous_trivial<T>::value)
+		sendrecvBuffer(sendData, dest, recvData, src, tag, comm);
+	else {
+		std::vector<char> sendPacked;
+		pack(sendData, sendPacked);
+		std::vector<char> recvPacked;
+		sendrecvBuffer(sendPacked, dest, recvPacked, src, tag, comm);
+		recvData = unpack<T>(recvPacked.data(), recvPacked.size());
+	}
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,243 @@
+#ifndef __MPI_TYPES_H__
+#define __MPI_TYPES_H__
+
+#include <cstddef>
+#include <vector>
+#include <string>
+#include <array>
+#include <complex>
+#include <type_traits>
+#include <utility>
+#include "mpi.h"
+
+/* The MPI datatype corresponding to a C++ type. 'defined' is true when the type has one
+   ('get' returns it), and 'native' when it is a predefined MPI datatype, that MPI can
+   reduce with its own operations. */
+template<typename T>
+struct mpi_type
+{
+	static const bool defined = false;
+	static const bool native = false;
+};
+
+#define MPICAPSULE_NATIVE_TYPE(CppType, MpiType) \
+	template<> \
+	struct mpi_type<CppType> \
+	{ \
+		static const bool defined = true; \
+		static const bool native = true; \
+		static MPI_Datatype get(){ return MpiType; } \
+	};
+
+MPICAPSULE_NATIVE_TYPE(char, MPI_CHAR)
+MPICAPSULE_NATIVE_TYPE(wchar_t, MPI_WCHAR)
+MPICAPSULE_NATIVE_TYPE(char16_t, MPI_UINT16_T)
+MPICAPSULE_NATIVE_TYPE(char32_t, MPI_UINT32_T)
+MPICAPSULE_NATIVE_TYPE(signed char, MPI_SIGNED_CHAR)
+MPICAPSULE_NATIVE_TYPE(unsigned char, MPI_UNSIGNED_CHAR)
+MPICAPSULE_NATIVE_TYPE(short, MPI_SHORT)
+MPICAPSULE_NATIVE_TYPE(unsigned short, MPI_UNSIGNED_SHORT)
+MPICAPSULE_NATIVE_TYPE(int, MPI_INT)
+MPICAPSULE_NATIVE_TYPE(unsigned, MPI_UNSIGNED)
+MPICAPSULE_NATIVE_TYPE(long, MPI_LONG)
+MPICAPSULE_NATIVE_TYPE(unsigned long, MPI_UNSIGNED_LONG)
+MPICAPSULE_NATIVE_TYPE(long long, MPI_LONG_LONG)
+MPICAPSULE_NATIVE_TYPE(unsigned long long, MPI_UNSIGNED_LONG_LONG)
+MPICAPSULE_NATIVE_TYPE(float, MPI_FLOAT)
+MPICAPSULE_NATIVE_TYPE(double, MPI_DOUBLE)
+MPICAPSULE_NATIVE_TYPE(long double, MPI_LONG_DOUBLE)
+MPICAPSULE_NATIVE_TYPE(bool, MPI_CXX_BOOL)
+MPICAPSULE_NATIVE_TYPE(std::complex<float>, MPI_CXX_FLOAT_COMPLEX)
+MPICAPSULE_NATIVE_TYPE(std::complex<double>, MPI_CXX_DOUBLE_COMPLEX)
+MPICAPSULE_NATIVE_TYPE(std::complex<long double>, MPI_CXX_LONG_DOUBLE_COMPLEX)
+
+#undef MPICAPSULE_NATIVE_TYPE
+
+/* The types whose values can be copied as raw bytes : the trivially copyable types, and
+   the pairs and arrays of such types (std::pair isn't trivially copyable, since it
+   defines its assignment operators). */
+template<typename T>
+struct bitwise_copyable : std::is_trivially_copyable<T> {};
+
+template<typename A, typename B>
+struct bitwise_copyable<std::pair<A, B>>
+	: std::integral_constant<bool, bitwise_copyable<A>::value && bitwise_copyable<B>::value> {};
+
+template<typename T, std::size_t N>
+struct bitwise_copyable<std::array<T, N>> : bitwise_copyable<T> {};
+
+/* The containers whose elements are bitwise copyable and stored contiguously, which
+   can be transferred as raw bytes instead of being serialized. */
+template<typename T>
+struct contiguous_trivial : std::false_type {};
+
+template<typename E, typename Alloc>
+struct contiguous_trivial<std::vector<E, Alloc>>
+	: std::integral_constant<bool, bitwise_copyable<E>::value && !std::is_same<E, bool>::value> {};
+
+template<typename C, typename Traits, typename Alloc>
+struct contiguous_trivial<std::basic_string<C, Traits, Alloc>> : std::true_type {};
+
+class MPI_Types
+{
+	public :
+
+	/**
+	 \brief This method creates an MPI datatype describing 'n' contiguous bytes, to transfer
+			(or read and write) one element of it when 'n' doesn't fit in the 'int' count of
+			the MPI functions. The bytes are described as blocks of 1 GB followed by the
+			remaining bytes.
+	 \param n The number of bytes described by the datatype.
+	 \return A committed MPI datatype, that must be freed with MPI_Type_free after its use.
+	*/
+	static MPI_Datatype bytes(std::size_t n){
+		const std::size_t blockSize = 1 << 30;
+
+		MPI_Datatype blockType;
+		MPI_Type_contiguous(blockSize, MPI_CHAR, &blockType);
+
+		int lengths[2] = {(int)(n/blockSize), (int)(n%blockSize)};
+		MPI_Aint displacements[2] = {0, (MPI_Aint)(n-n%blockSize)};
+		MPI_Datatype types[2] = {blockType, MPI_CHAR};
+
+		MPI_Datatype bytesType;
+		MPI_Type_create_struct(2, lengths, displacements, types, &bytesType);
+		MPI_Type_commit(&bytesType);
+		MPI_Type_free(&blockType);
+
+		return bytesType;
+	}
+
+	/**
+	 \brief This method creates an MPI datatype describing several blocks of bytes located
+			anywhere in memory, so that they can be transferred (or written) at once as if they
+			were contiguous. The datatype uses absolute addresses : it must be used with
+			MPI_BOTTOM as buffer.
+	 \param blocks The address and the size in bytes of each block.
+	 \return A committed MPI datatype, that must be freed with MPI_Type_free after its use.
+	*/
+	static MPI_Datatype blocks(std::vector<std::pair<const void*, std::size_t>> const& blocks){
+		std::vector<int> lengths(blocks.size(), 1);
+		std::vector<MPI_Aint> addresses(blocks.size());
+		std::vector<MPI_Datatype> types(blocks.size());
+		for (std::size_t i = 0; i < blocks.size(); ++i){
+			MPI_Get_address(blocks[i].first, &addresses[i]);
+			types[i] = bytes(blocks[i].second);
+		}
+
+		MPI_Datatype blocksType;
+		MPI_Type_create_struct(blocks.size(), lengths.data(), addresses.data(), types.data(), &blocksType);
+		MPI_Type_commit(&blocksType);
+		for (std::size_t i = 0; i < types.size(); ++i)
+			MPI_Type_free(&types[i]);
+
+		return blocksType;
+	}
+
+	/**
+	 \brief This method creates the MPI datatype of a struct from pointers to its members, whose
+			types must have an MPI datatype (see mpi_type). The displacements of the members
+			are measured on an object of the struct, and the extent of the datatype is
+			sizeof(S), so that arrays of structs can be transferred with it.
+	 \param members Pointers to the members of S, for example &S::x, &S::y.
+	 \return A committed MPI datatype.
+	*/
+	template<typename S, typename... Members>
+	static MPI_Datatype structType(Members S::*... members){
+		static_assert(bitwise_copyable<S>::value, "Only bitwise copyable structs can have an MPI datatype.");
+		static_assert((mpi_type<Members>::defined && ...), "All the members of the struct must have an MPI datatype.");
+
+		S object{};
+		MPI_Aint base;
+		MPI_Get_address(&object, &base);
+
+		int lengths[] = {(static_cast<void>(members), 1)...};
+		MPI_Aint displacements[] = {address(&(object.*members))-base...};
+		MPI_Datatype types[] = {mpi_type<Members>::get()...};
+
+		MPI_Datatype membersType;
+		MPI_Type_create_struct(sizeof...(Members), lengths, displacements, types, &membersType);
+		return resized(membersType, sizeof(S));
+	}
+
+	/**
+	 \brief This method creates the MPI datatype of an array of 'n' elements of type 'elementType'
+			occupying 'size' bytes.
+	 \return A committed MPI datatype.
+	*/
+	static MPI_Datatype arrayType(MPI_Datatype elementType, std::size_t n, std::size_t size){
+		MPI_Datatype elementsType;
+		MPI_Type_contiguous(n, elementType, &elementsType);
+		return resized(elementsType, size);
+	}
+
+	private :
+
+	static MPI_Aint address(void const* location){
+		MPI_Aint addr;
+		MPI_Get_address(location, &addr);
+		return addr;
+	}
+
+	// Gives the extent 'size' to 'type' (freed), to include the padding at the end of the C++ type.
+	static MPI_Datatype resized(MPI_Datatype type, std::size_t size){
+		MPI_Datatype resizedType;
+		MPI_Type_create_resized(type, 0, size, &resizedType);
+		MPI_Type_commit(&resizedType);
+		MPI_Type_free(&type);
+		return resizedType;
+	}
+};
+
+/* Derived datatypes of pairs and arrays. They are created the first time they are used,
+   after MPI_Init, and kept until the end of the program. */
+template<typename A, typename B>
+struct mpi_type<std::pair<A, B>>
+{
+	static const bool defined = mpi_type<A>::defined && mpi_type<B>::defined;
+	static const bool native = false;
+	static MPI_Datatype get(){
+		static MPI_Datatype type = MPI_Types::structType<std::pair<A, B>>(&std::pair<A, B>::first, &std::pair<A, B>::second);
+		return type;
+	}
+};
+
+template<typename T, std::size_t N>
+struct mpi_type<std::array<T, N>>
+{
+	static const bool defined = mpi_type<T>::defined;
+	static const bool native = false;
+	static MPI_Datatype get(){
+		static MPI_Datatype type = MPI_Types::arrayType(mpi_type<T>::get(), N, sizeof(std::array<T, N>));
+		return type;
+	}
+};
+
+template<typename T, std::size_t N>
+struct mpi_type<T[N]>
+{
+	static const bool defined = mpi_type<T>::defined;
+	static const bool native = false;
+	static MPI_Datatype get(){
+		static MPI_Datatype type = MPI_Types::arrayType(mpi_type<T>::get(), N, sizeof(T[N]));
+		return type;
+	}
+};
+
+/* MPICAPSULE_STRUCT_TYPE(Type, members...) defines the MPI datatype of a struct from pointers
+   to its members, so that it can be transferred and reduced by MPI without being serialized.
+   It must be used in the global namespace, for example :
+   MPICAPSULE_STRUCT_TYPE(Particle, &Particle::position, &Particle::mass) */
+#define MPICAPSULE_STRUCT_TYPE(Type, ...) \
+	template<> \
+	struct mpi_type<Type> \
+	{ \
+		static const bool defined = true; \
+		static const bool native = false; \
+		static MPI_Datatype get(){ \
+			static MPI_Datatype type = MPI_Types::structType<Type>(__VA_ARGS__); \
+			return type; \
+		} \
+	};
+
+#endif
@@ -0,0 +1,265 @@
+#ifndef __PENDINGREDUCE_H__
+#define __PENDINGREDUCE_H__
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <utility>
+#include <type_traits>
+#include "mpi.h"
+#include "MPI_Types.hpp"
+#include "ReduceOps.hpp"
+#include "ReducedData.hpp"
+#include "Reduction.hpp"
+#include "MPI_SendRecv.hpp"
+
+template <typename T>
+class PendingReduce
+{
+	private :
+
+	enum Phase { Idle, Probing, Receiving, Sending, Complete };
+
+	/* The state of the reduction is kept at a fixed address, since MPI keeps pointers
+	   to its buffers until the communications are completed. */
+	struct State
+	{
+		int procRank;
+		int masterProc;
+		T data;
+		Phase phase;
+		MPI_Request request;
+
+		// Reduction done by MPI_Ireduce (native operations and bitwise copyable types).
+		T sendData;
+		std::unique_ptr<UserOp<T>> userOp;
+
+		// Reduction of serialized data along the trees of 'Reduction::stages'.
+		std::function<void(T&, T&&)> merge;
+		std::vector<MPI_Comm> stages;
+		std::size_t stage;
+		int mask;
+		int tag;
+		std::vector<char> sendBuf;
+		std::vector<char> recvBuf;
+		// Data received as raw bytes (see 'contiguous_trivial').
+		T recvData;
+	};
+
+	std::unique_ptr<State> state;
+
+	PendingReduce(int rank, int master) : state(new State()){
+		state->procRank = rank;
+		state->masterProc = master;
+		state->phase = Idle;
+		state->request = MPI_REQUEST_NULL;
+	}
+
+	// Advances the reduction of serialized data as far as possible without blocking.
+	void progress(){
+		State& s = *state;
+		while (s.phase != Complete){
+			int flag;
+			if (s.phase == Idle){
+				if (s.stage == s.stages.size()){
+					s.phase = Complete;
+					break;
+				}
+
+				// Binomial tree on the communicator of the stage, rooted at rank 0 : at
+				// step 'mask', the processors with this bit set send their data to the
+				// processor 'mask' ranks lower and leave the reduction.
+				MPI_Comm comm = s.stages[s.stage];
+				int rank, size;
+				MPI_Comm_rank(comm, &rank);
+				MPI_Comm_size(comm, &size);
+				if (s.mask >= size){
+					++s.stage;
+					s.mask = 1;
+				}
+				else if (rank & s.mask){
+					// The data is sent in a single message, whose size the receiver finds by
+					// probing it. The vectors of bitwise copyable elements are sent straight
+					// from their memory, which isn't modified anymore once the processor
+					// sends its data.
+					const void* sendPtr;
+					std::size_t sendBytes;
+					if constexpr (contiguous_trivial<T>::value){
+						sendPtr = s.data.data();
+						sendBytes = s.data.size()*sizeof(s.data[0]);
+					}
+					else {
+						MPI_SendRecv::pack(s.data, s.sendBuf);
+						sendPtr = s.sendBuf.data();
+						sendBytes = s.sendBuf.size();
+					}
+					MPI_Datatype bytesType = MPI_Types::bytes(sendBytes);
+					MPI_Isend(sendPtr, 1, bytesType, rank-s.mask, s.tag, comm, &s.request);
+					MPI_Type_free(&bytesType);
+					s.phase = Sending;
+				}
+				else if (rank+s.mask < size)
+					s.phase = Probing;
+				else
+					s.mask *= 2;
+			}
+			else if (s.phase == Probing){
+				MPI_Comm comm = s.stages[s.stage];
+				int rank;
+				MPI_Comm_rank(comm, &rank);
+				MPI_Message message;
+				MPI_Status status;
+				MPI_Improbe(rank+s.mask, s.tag, comm, &flag, &message, &status);
+				if (!flag)
+					break;
+
+				// The message is received directly in the buffer the data is read from.
+				MPI_Count recvBytes;
+				MPI_Get_elements_x(&status, MPI_CHAR, &recvBytes);
+				void* recvPtr;
+				if constexpr (contiguous_trivial<T>::value){
+					s.recvData.resize(recvBytes/sizeof(s.recvData[0]));
+					recvPtr = s.recvData.data();
+				}
+				else {
+					s.recvBuf.resize(recvBytes);
+					recvPtr = s.recvBuf.data();
+				}
+				MPI_Datatype bytesType = MPI_Types::bytes(recvBytes);
+				MPI_Imrecv(recvPtr, 1, bytesType, &message, &s.request);
+				MPI_Type_free(&bytesType);
+				s.phase = Receiving;
+			}
+			else if (s.phase == Receiving){
+				MPI_Test(&s.request, &flag, MPI_STATUS_IGNORE);
+				if (!flag)
+					break;
+
+				if constexpr (contiguous_trivial<T>::value)
+					s.merge(s.data, std::move(s.recvData));
+				else
+					s.merge(s.data, MPI_SendRecv::unpack<T>(s.recvBuf.data(), s.recvBuf.size()));
+				s.mask *= 2;
+				s.phase = Idle;
+			}
+			else if (s.phase == Sending){
+				MPI_Test(&s.request, &flag, MPI_STATUS_IGNORE);
+				if (!flag)
+					break;
+
+				// A processor having sent its data has no further part in the reduction.
+				s.phase = Complete;
+			}
+		}
+	}
+
+	public :
+
+	/**
+	 \brief This method starts the reduction of 'localData' towards the processor 'master' with
+			MPI_Ireduce, for the types and operations supported by MPI.
+	 \param type The MPI datatype of T.
+	 \param op The MPI operation.
+	*/
+	static PendingReduce start(int rank, int master, T localData, MPI_Datatype type, MPI_Op op){
+		PendingReduce pending(rank, master);
+		State& s = *pending.state;
+		s.sendData = std::move(localData);
+		s.data = s.sendData;
+		MPI_Ireduce(&s.sendData, &s.data, 1, type, op, master, MPI_COMM_WORLD, &s.request);
+		s.phase = Sending;
+		return pending;
+	}
+
+	/**
+	 \brief This method starts the reduction of 'localData' towards the processor 'master',
+			combining the data in place with 'merge' (see InPlaceCombiner). Bitwise copyable
+			types are reduced by MPI_Ireduce through a user MPI operation, the other ones are
+			serialized and sent along the same trees as 'Reduction::reduce'.
+	*/
+	static PendingReduce start(int rank, int master, T localData, std::function<void(T&, T&&)> merge){
+		if constexpr (bitwise_copyable<T>::value){
+			std::unique_ptr<UserOp<T>> userOp(new UserOp<T>(merge));
+			PendingReduce pending = start(rank, master, std::move(localData), userOp->getType(), userOp->getOp());
+			pending.state->userOp = std::move(userOp);
+			return pending;
+		}
+		else {
+			PendingReduce pending(rank, master);
+			State& s = *pending.state;
+			s.data = std::move(localData);
+			s.merge = std::move(merge);
+			s.stages = Reduction::stages(master);
+			s.stage = 0;
+			s.mask = 1;
+			s.tag = Reduction::nextTag();
+			pending.progress();
+			return pending;
+		}
+	}
+
+	PendingReduce(PendingReduce&&) = default;
+
+	// MPI may still use the buffers of a reduction in progress, so it is completed
+	// before they are destroyed.
+	~PendingReduce(){
+		if (state && state->phase != Complete)
+			wait();
+	}
+
+	/**
+	 \brief This method makes the reduction progress without blocking.
+	 \return true if the reduction is complete on this processor (the result is then available
+			through 'wait' on the master), false otherwise.
+	*/
+	bool test(){
+		State& s = *state;
+		if (s.phase == Complete)
+			return true;
+
+		// Bitwise copyable types are always reduced by MPI_Ireduce.
+		if constexpr (bitwise_copyable<T>::value){
+			int flag;
+			MPI_Test(&s.request, &flag, MPI_STATUS_IGNORE);
+			if (flag){
+				// The MPI operation is freed as soon as it isn't used anymore, rather than
+				// with the PendingReduce object, which may outlive MPI.
+				s.userOp.reset();
+				s.phase = Complete;
+			}
+		}
+		else
+			progress();
+
+		return s.phase == Complete;
+	}
+
+	/**
+	 \brief This method blocks until the reduction is complete on this processor.
+	 \return A ReducedData<T> object. Only the ReducedData object on the master node will
+			actually contain the result of the reduction, the rest will be empty.
+	*/
+	ReducedData<T> wait(){
+		State& s = *state;
+		while (!test()){
+			// MPI_Probe blocks until the message of the next processor arrives, without
+			// receiving it (see 'progress').
+			if (s.phase == Probing){
+				MPI_Comm comm = s.stages[s.stage];
+				int rank;
+				MPI_Comm_rank(comm, &rank);
+				MPI_Probe(rank+s.mask, s.tag, comm, MPI_STATUS_IGNORE);
+			}
+			else
+				MPI_Wait(&s.request, MPI_STATUS_IGNORE);
+		}
+
+		ReducedData<T> result(s.procRank, s.masterProc);
+		if (s.procRank == s.masterProc)
+			result.setData(s.data);
+
+		return result;
+	}
+};
+
+#endif
@@ -0,0 +1,193 @@
+#ifndef __REDUCEOPS_H__
+#define __REDUCEOPS_H__
+
+#include <functional>
+#include <type_traits>
+#include <cstring>
+#include <utility>
+#include "mpi.h"
+#include "MPI_Types.hpp"
+
+/* Function objects returning the smallest (Min) or largest (Max) of two values,
+   to be used with 'DistributedData::reduce' like std::plus or std::multiplies. */
+template<typename T = void>
+struct Min
+{
+	T operator()(T const& a, T const& b) const {
+		return (b < a) ? b : a;
+	}
+};
+
+template<typename T = void>
+struct Max
+{
+	T operator()(T const& a, T const& b) const {
+		return (a < b) ? b : a;
+	}
+};
+
+template<>
+struct Min<void>
+{
+	template<typename T>
+	T operator()(T const& a, T const& b) const {
+		return (b < a) ? b : a;
+	}
+};
+
+template<>
+struct Max<void>
+{
+	template<typename T>
+	T operator()(T const& a, T const& b) const {
+		return (a < b) ? b : a;
+	}
+};
+
+/* NativeOp<Op, T>::value is true when reducing values of type T with the function
+   object Op can be done by MPI itself, with the predefined operation NativeOp<Op, T>::op().
+   MPI only allows arithmetic operations on numbers (comparisons only on real numbers), and
+   logical and bitwise operations on integers ('char' and 'wchar_t' are character types for
+   MPI, they can't be reduced). */
+template<typename Op, typename T>
+struct NativeOp
+{
+	static const bool value = false;
+};
+
+#define MPICAPSULE_NATIVE_OP(Functor, MpiOp, Condition) \
+	template<typename T> \
+	struct NativeOp<Functor<T>, T> \
+	{ \
+		static const bool value = mpi_type<T>::native && !std::is_same<T, char>::value && !std::is_same<T, wchar_t>::value && (Condition); \
+		static MPI_Op op(){ return MpiOp; } \
+	}; \
+	template<typename T> \
+	struct NativeOp<Functor<void>, T> \
+	{ \
+		static const bool value = mpi_type<T>::native && !std::is_same<T, char>::value && !std::is_same<T, wchar_t>::value && (Condition); \
+		static MPI_Op op(){ return MpiOp; } \
+	};
+
+MPICAPSULE_NATIVE_OP(std::plus, MPI_SUM, (!std::is_same<T, bool>::value))
+MPICAPSULE_NATIVE_OP(std::multiplies, MPI_PROD, (!std::is_same<T, bool>::value))
+MPICAPSULE_NATIVE_OP(Min, MPI_MIN, (std::is_arithmetic<T>::value && !std::is_same<T, bool>::value))
+MPICAPSULE_NATIVE_OP(Max, MPI_MAX, (std::is_arithmetic<T>::value && !std::is_same<T, bool>::value))
+MPICAPSULE_NATIVE_OP(std::logical_and, MPI_LAND, (std::is_integral<T>::value))
+MPICAPSULE_NATIVE_OP(std::logical_or, MPI_LOR, (std::is_integral<T>::value))
+MPICAPSULE_NATIVE_OP(std::bit_and, MPI_BAND, (std::is_integral<T>::value && !std::is_same<T, bool>::value))
+MPICAPSULE_NATIVE_OP(std::bit_or, MPI_BOR, (std::is_integral<T>::value && !std::is_same<T, bool>::value))
+MPICAPSULE_NATIVE_OP(std::bit_xor, MPI_BXOR, (std::is_integral<T>::value && !std::is_same<T, bool>::value))
+
+#undef MPICAPSULE_NATIVE_OP
+
+/* The reductions combine the data in place : 'merge(acc, std::move(incoming))' adds the
+   data of 'incoming' to 'acc', and may steal its content. InPlaceCombiner<T, F> gives this
+   form to any combiner : the in-place ones (void func(T& acc, T&& incoming)) are called
+   directly, and the ones returning a new object (T func(T&, T&)) are assigned to 'acc'. */
+template<typename T, typename F>
+class InPlaceCombiner
+{
+	private :
+
+	F func;
+
+	public :
+
+	InPlaceCombiner(F combiner) : func(std::move(combiner)){}
+
+	void operator()(T& acc, T&& incoming){
+		if constexpr (std::is_invocable<F&, T&, T&&>::value){
+			if constexpr (std::is_void<typename std::invoke_result<F&, T&, T&&>::type>::value)
+				func(acc, std::move(incoming));
+			else
+				acc = func(acc, std::move(incoming));
+		}
+		else
+			acc = func(acc, incoming);
+	}
+};
+
+/* UserOp<T> wraps a function combining two values of a bitwise copyable type T in an
+   MPI operation (commutative by default), over the MPI datatype of T (see mpi_type) or,
+   when it has none, a datatype made of the sizeof(T) bytes of a value, so that MPI_Reduce
+   can apply it without any serialization. The operation and the datatype exist as long
+   as the UserOp object. */
+template<typename T>
+class UserOp
+{
+	private :
+
+	MPI_Op op;
+	MPI_Datatype type;
+	std::function<void(T&, T&&)> merge;
+
+	// MPI operations are plain C functions : each UserOp object is attached to its
+	// datatype as an attribute, since MPI passes the datatype to the operation. This
+	// keeps the right combiner when several reductions are in progress at once.
+	static int keyval(){
+		static int key = MPI_KEYVAL_INVALID;
+		if (key == MPI_KEYVAL_INVALID)
+			MPI_Type_create_keyval(MPI_TYPE_NULL_COPY_FN, MPI_TYPE_NULL_DELETE_FN, &key, nullptr);
+		return key;
+	}
+
+	// Computes inout[i] = in[i] op inout[i]. The values are copied since MPI doesn't
+	// guarantee that its buffers are aligned for T (as void*, since std::pair defines
+	// its assignments but can be copied as bytes).
+	static void apply(void* in, void* inout, int* len, MPI_Datatype* datatype){
+		void* attr;
+		int found;
+		MPI_Type_get_attr(*datatype, keyval(), &attr, &found);
+		UserOp* self = static_cast<UserOp*>(attr);
+
+		char* inBytes = static_cast<char*>(in);
+		char* inoutBytes = static_cast<char*>(inout);
+		for (int i = 0; i < *len; ++i){
+			T acc, incoming;
+			std::memcpy(static_cast<void*>(&acc), inBytes+i*sizeof(T), sizeof(T));
+			std::memcpy(static_cast<void*>(&incoming), inoutBytes+i*sizeof(T), sizeof(T));
+			self->merge(acc, std::move(incoming));
+			std::memcpy(inoutBytes+i*sizeof(T), &acc, sizeof(T));
+		}
+	}
+
+	public :
+
+	/**
+	 \brief This constructor creates the MPI operation applying 'combiner', called as
+			'combiner(acc, std::move(incoming))' (see InPlaceCombiner).
+	 \param commute Whether MPI may combine the values in any order. It must be false when
+			the order of the ranks matters, as for prefix scans of non commutative operations.
+	*/
+	UserOp(std::function<void(T&, T&&)> combiner, bool commute = true) : merge(std::move(combiner)){
+		MPI_Op_create(&UserOp::apply, commute ? 1 : 0, &op);
+		// The datatype of T is shared by all the UserOp objects : each one uses its own
+		// copy of it, to which it is attached.
+		if constexpr (mpi_type<T>::defined)
+			MPI_Type_dup(mpi_type<T>::get(), &type);
+		else {
+			MPI_Type_contiguous(sizeof(T), MPI_BYTE, &type);
+			MPI_Type_commit(&type);
+		}
+		MPI_Type_set_attr(type, keyval(), this);
+	}
+
+	~UserOp(){
+		MPI_Op_free(&op);
+		MPI_Type_free(&type);
+	}
+
+	UserOp(UserOp const&) = delete;
+	UserOp& operator=(UserOp const&) = delete;
+
+	MPI_Op getOp() const {
+		return op;
+	}
+
+	MPI_Datatype getType() const {
+		return type;
+	}
+};
+
+#endif
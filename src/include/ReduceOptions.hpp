@@ -0,0 +1,150 @@
+#ifndef __REDUCEOPTIONS_H__
+#define __REDUCEOPTIONS_H__
+
+#include <string>
+#include <cstdlib>
+
+class ReduceOptions
+{
+	public :
+
+	/* The algorithms used to reduce serialized data (the types supported by MPI are
+	   always reduced by MPI_Reduce). */
+	enum Algorithm
+	{
+		Automatic,	// Chosen at each reduction from the size of the data. Finding the
+					// largest size among the processors costs an extra collective call
+					// (MPI_Allreduce) per reduction ; forcing an algorithm avoids it.
+		BinaryTree,	// Binary tree, inside the nodes and then between them.
+		KaryTree,	// Tree in which each processor receives from up to 'fanin' others.
+		Gather		// MPI_Gatherv of all the data on the master, which combines it.
+	};
+
+	private :
+
+	Algorithm algorithm;
+	// Largest total size in bytes of the data of all the processors gathered on the master.
+	long long gatherBytes;
+	// Largest size in bytes of the data of a processor reduced along a k-ary tree.
+	long long karyBytes;
+	int fanin;
+
+	public :
+
+	ReduceOptions() : algorithm(Automatic), gatherBytes(256*1024), karyBytes(64*1024), fanin(4){}
+
+	/**
+	 \brief This method forces the algorithm used by all the reductions of serialized data,
+			or restores the automatic choice (ReduceOptions::Automatic).
+	*/
+	ReduceOptions& setAlgorithm(Algorithm newAlgorithm){
+		algorithm = newAlgorithm;
+		return *this;
+	}
+
+	/**
+	 \brief This method sets the total size in bytes of the serialized data of all the processors
+			up to which the data is simply gathered on the master to be combined there.
+	*/
+	ReduceOptions& setGatherBytes(long long bytes){
+		gatherBytes = bytes;
+		return *this;
+	}
+
+	/**
+	 \brief This method sets the size in bytes of the serialized data of a processor up to which
+			the data is reduced along a k-ary tree rather than a binary tree.
+	*/
+	ReduceOptions& setKaryBytes(long long bytes){
+		karyBytes = bytes;
+		return *this;
+	}
+
+	/**
+	 \brief This method sets the number of processors whose data is received by each processor
+			of a k-ary tree.
+	*/
+	ReduceOptions& setFanin(int newFanin){
+		fanin = newFanin < 2 ? 2 : newFanin;
+		return *this;
+	}
+
+	Algorithm getAlgorithm() const {
+		return algorithm;
+	}
+
+	long long getGatherBytes() const {
+		return gatherBytes;
+	}
+
+	long long getKaryBytes() const {
+		return karyBytes;
+	}
+
+	int getFanin() const {
+		return fanin;
+	}
+
+	/**
+	 \brief This method chooses the algorithm reducing serialized data, when it isn't forced.
+	 \param maxBytes The largest size of the serialized data among the processors.
+	 \param nProcs The number of processors taking part in the reduction.
+	*/
+	Algorithm select(long long maxBytes, int nProcs) const {
+		if (algorithm != Automatic)
+			return algorithm;
+
+		// Small data is gathered in a single collective call rather than sent along the
+		// log2(nProcs) levels of a tree. Medium data is sent along a tree with fewer levels,
+		// and large data along the binary tree, in which each processor receives less.
+		if (maxBytes*nProcs <= gatherBytes)
+			return Gather;
+		if (maxBytes <= karyBytes)
+			return KaryTree;
+		return BinaryTree;
+	}
+
+	/**
+	 \brief This method overrides the options with the ones defined in the environment :
+			MPICAPSULE_REDUCE_ALGORITHM ('auto', 'tree', 'kary' or 'gather'),
+			MPICAPSULE_REDUCE_GATHER_BYTES, MPICAPSULE_REDUCE_KARY_BYTES and
+			MPICAPSULE_REDUCE_FANIN.
+	*/
+	void loadEnvironment(){
+		const char* env = std::getenv("MPICAPSULE_REDUCE_ALGORITHM");
+		if (env != nullptr){
+			std::string name(env);
+			if (name == "auto")
+				algorithm = Automatic;
+			else if (name == "tree")
+				algorithm = BinaryTree;
+			else if (name == "kary")
+				algorithm = KaryTree;
+			else if (name == "gather")
+				algorithm = Gather;
+		}
+
+		env = std::getenv("MPICAPSULE_REDUCE_GATHER_BYTES");
+		if (env != nullptr)
+			gatherBytes = std::atoll(env);
+
+		env = std::getenv("MPICAPSULE_REDUCE_KARY_BYTES");
+		if (env != nullptr)
+			karyBytes = std::atoll(env);
+
+		env = std::getenv("MPICAPSULE_REDUCE_FANIN");
+		if (env != nullptr)
+			setFanin(std::atoi(env));
+	}
+
+	/**
+	 \brief This method returns the options used by all the reductions of the program
+			(see 'MPI_Context::setReduceOptions').
+	*/
+	static ReduceOptions& current(){
+		static ReduceOptions options;
+		return options;
+	}
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <string>
 #include <functional>
+#include <utility>
 #include "MPI_Context.hpp"
 
 template <typename T>
@@ -18,14 +19,14 @@ class ReducedData
 	public:
 		
 	ReducedData(int rank, int master) : procRank(rank), masterProc(master){}
-	ReducedData(int rank, int master, T localData) : procRank(rank), masterProc(master), data(localData){}
+	ReducedData(int rank, int master, T localData) : procRank(rank), masterProc(master), data(std::move(localData)){}
 	
 	T getData(){
 		return data;
 	}
 	
 	void setData(T newData){
-		data = newData;
+		data = std::move(newData);
 	}
 	
 	/**
@@ -39,7 +40,7 @@ class ReducedData
 	template<typename R>
 	ReducedData<R> map(R (*func)(T&)){
 		R result = func(data);
-		ReducedData<R> resultData(procRank, masterProc, result);
+		ReducedData<R> resultData(procRank, masterProc, std::move(result));
 		return resultData;
 	}
 	
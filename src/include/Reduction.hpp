@@ -0,0 +1,487 @@
+#ifndef __REDUCTION_H__
+#define __REDUCTION_H__
+
+#include <map>
+#include <vector>
+#include <string>
+#include <utility>
+#include <climits>
+#include "mpi.h"
+#include "MPI_SendRecv.hpp"
+#include "MPI_Types.hpp"
+#include "Serialization.hpp"
+#include "ReduceOptions.hpp"
+
+class Reduction
+{
+	private :
+
+	/* The communicators used to reduce data towards a given root : one communicator
+	   per node, grouping the processors sharing the same memory, and one communicator
+	   grouping the leaders of the nodes (MPI_COMM_NULL on the other processors).
+	   The root is rank 0 in both its node and the leaders communicators. */
+	struct Topology
+	{
+		MPI_Comm nodeComm;
+		MPI_Comm leadersComm;
+	};
+
+	static Topology const& topology(int root){
+		// The communicators are created once for each root, when it is first used.
+		static std::map<int, Topology> topologies;
+		auto found = topologies.find(root);
+		if (found != topologies.end())
+			return found->second;
+
+		int rank;
+		MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+		int key = rank==root ? 0 : 1;
+
+		Topology topo;
+		MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, key, MPI_INFO_NULL, &topo.nodeComm);
+		int nodeRank;
+		MPI_Comm_rank(topo.nodeComm, &nodeRank);
+		MPI_Comm_split(MPI_COMM_WORLD, nodeRank==0 ? 0 : MPI_UNDEFINED, key, &topo.leadersComm);
+
+		return topologies.emplace(root, topo).first->second;
+	}
+
+	public :
+
+	/**
+	 \brief This method organizes the reduction of data on the processor of rank 0 in a
+			communicator along a binary tree : at each step, half of the active processors send
+			their data to the other half, which combine it with their own.
+	 \param comm The communicator on which the data is reduced.
+	 \param send A function called with the rank of the destination when the processor must
+			send its data.
+	 \param receive A function called with the rank of the source when the processor must
+			receive data and combine it with its own.
+	*/
+	template<typename Send, typename Receive>
+	static void schedule(MPI_Comm comm, Send send, Receive receive){
+		int procRank, nProcs;
+		MPI_Comm_rank(comm, &procRank);
+		MPI_Comm_size(comm, &nProcs);
+
+		// At the beginning of the reduction, all processors are active, and half
+		// of them receives from the other half their data.
+		int activeProcs(nProcs);
+		int receivers((nProcs+1)/2);
+		int nb_recv_odd(nProcs%2);
+
+		while (activeProcs>1){
+			// A processor is a sender when its rank is higher than half the number of
+			// active processors and smaller than the number of active processors.
+			// After a processor has sent its data to a receiver, it becomes 'inactive'.
+			if (procRank >= receivers && procRank < activeProcs){
+				send(procRank-receivers);
+			}
+			// A processor is a receiver as long as its rank is smaller than half the number
+			// of active processors. Receivers combine their data with the received one,
+			// and then send the result when they become senders.
+			else if (procRank < receivers){
+				if (nb_recv_odd==0 || (nb_recv_odd!=0 && procRank < receivers-1)){
+					receive(procRank+receivers);
+				}
+			}
+
+			// At every iteration, half the processor have sent their data and become
+			// inactive. The variable 'nb_recv_odd' is used to determine whether there
+			// will be an odd number of receivers at the next iteration. If so, the last of
+			// the receivers won't receive anything during the next step.
+			activeProcs = (activeProcs+1)/2;
+			receivers = (activeProcs+1)/2;
+			nb_recv_odd = activeProcs%2;
+		}
+	}
+
+	/**
+	 \brief This method reduces the data of all the processors of a communicator on the processor
+			of rank 0 in it (see 'schedule').
+	 \param data The data of the processor. On rank 0, it contains the result at the end.
+	 \param merge The function combining two objects of type T in place (see InPlaceCombiner).
+	 \param comm The communicator on which the data is reduced.
+	*/
+	template<typename T, typename Merge>
+	static void tree(T& data, Merge& merge, MPI_Comm comm){
+		schedule(comm,
+			[&](int dest){ MPI_SendRecv::send(data, dest, 0, comm); },
+			[&](int src){
+				T recvData; // Container for the data received during the reduction.
+				MPI_SendRecv::recv(recvData, src, 0, comm);
+				merge(data, std::move(recvData));
+			});
+	}
+
+	/**
+	 \brief This method sends a container to a processor as a stream of segments of at most
+			'segmentElements' elements, each serialized separately. Two segments are in flight
+			at most : the next segment is serialized while the previous one is transferred.
+			An empty message marks the end of the stream.
+	*/
+	template<typename T>
+	static void sendSegments(T const& data, std::size_t segmentElements, int dest, int tag, MPI_Comm comm){
+		std::vector<char> buffers[2];
+		MPI_Request requests[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+		int current = 0;
+
+		auto first = data.begin();
+		while (first != data.end()){
+			auto last = first;
+			for (std::size_t i = 0; i < segmentElements && last != data.end(); ++i)
+				++last;
+
+			// The buffer is reused once the segment previously sent from it is transferred.
+			MPI_Wait(&requests[current], MPI_STATUS_IGNORE);
+			MPI_SendRecv::pack(T(first, last), buffers[current]);
+			MPI_Datatype bytesType = MPI_Types::bytes(buffers[current].size());
+			MPI_Isend(buffers[current].data(), 1, bytesType, dest, tag, comm, &requests[current]);
+			MPI_Type_free(&bytesType);
+
+			current = 1-current;
+			first = last;
+		}
+
+		MPI_Waitall(2, requests, MPI_STATUSES_IGNORE);
+		MPI_Send(nullptr, 0, MPI_CHAR, dest, tag, comm);
+	}
+
+	/**
+	 \brief This method receives a container sent by 'sendSegments', and combines each of its
+			segments with 'data' as soon as it arrives, so the whole container is never held
+			in serialized form.
+	*/
+	template<typename T, typename Merge>
+	static void recvSegments(T& data, Merge& merge, int src, int tag, MPI_Comm comm){
+		std::vector<char> buffer;
+		while (true){
+			MPI_Message message;
+			MPI_Status status;
+			MPI_Mprobe(src, tag, comm, &message, &status);
+			MPI_SendRecv::mrecvBuffer(buffer, message, status);
+			if (buffer.empty())
+				break;
+
+			T segment = MPI_SendRecv::unpack<T>(buffer.data(), buffer.size());
+			merge(data, std::move(segment));
+		}
+	}
+
+	/**
+	 \brief This method reduces the data of all the processors of a communicator on the processor
+			'root', along a tree in which each processor receives the data of up to 'fanin'
+			processors : the tree has fewer levels than the binary tree, so the data goes
+			through fewer processors before reaching 'root'. The data of the children of a
+			processor is combined in the order in which it arrives (MPI_Mprobe from any source),
+			so a slow child doesn't delay the combination of the data of the other ones.
+	 \param data The data of the processor. On 'root', it contains the result at the end.
+	 \param merge The function combining two objects of type T in place. It must be associative
+			and commutative, as the data isn't combined in the order of the ranks.
+	 \param fanin The number of children of each processor in the tree.
+	 \param comm The communicator on which the data is reduced.
+	 \param root The rank of the processor receiving the result in 'comm'.
+	 \param tag The tag of the messages of the reduction. As the data of the children is
+			received from any source, it must differ from the tags of the other reductions
+			that may be in progress on 'comm' (see 'nextTag').
+	*/
+	template<typename T, typename Merge>
+	static void karyTree(T& data, Merge& merge, int fanin, MPI_Comm comm, int root, int tag){
+		int procRank, nProcs;
+		MPI_Comm_rank(comm, &procRank);
+		MPI_Comm_size(comm, &nProcs);
+
+		// The tree is built on the ranks relative to 'root' : the children of the relative
+		// rank r are the relative ranks r*fanin+1 to r*fanin+fanin.
+		int relRank = (procRank-root+nProcs)%nProcs;
+		int nChildren = 0;
+		for (int child = relRank*fanin+1; child <= relRank*fanin+fanin && child < nProcs; ++child)
+			++nChildren;
+
+		// Only the children of the processor send it messages with the tag of the reduction,
+		// so MPI_Mprobe from any source blocks until the data of one of them arrives, and
+		// the data is combined in the order in which it arrives.
+		for (int n = 0; n < nChildren; ++n){
+			MPI_Message message;
+			MPI_Status status;
+			MPI_Mprobe(MPI_ANY_SOURCE, tag, comm, &message, &status);
+
+			T recvData;
+			MPI_SendRecv::mrecv(recvData, message, status);
+			merge(data, std::move(recvData));
+		}
+
+		if (relRank != 0)
+			MPI_SendRecv::send(data, ((relRank-1)/fanin+root)%nProcs, tag, comm);
+	}
+
+	/**
+	 \brief This method returns the smallest number of children per processor for which a tree
+			reducing the data of 'nProcs' processors has at most 'depth' levels of processors
+			sending their data (see 'karyTree').
+	*/
+	static int fanin(int nProcs, int depth){
+		if (depth < 1)
+			depth = 1;
+
+		int k = 2;
+		while (true){
+			// A tree of fanin k has at most 'depth' levels below its root when k^depth
+			// reaches the number of processors.
+			long long reached = 1;
+			for (int level = 0; level < depth && reached < nProcs; ++level)
+				reached *= k;
+			if (reached >= nProcs)
+				return k;
+			++k;
+		}
+	}
+
+	/**
+	 \brief This method gathers the serialized data of all the processors in MPI_COMM_WORLD on
+			the processor 'root' with a single MPI_Gatherv, and combines it there in the order
+			of the ranks. When the total size of the packed data doesn't fit in an int, the
+			data is reduced along the binary tree instead.
+	 \param data The data of the processor. On 'root', it contains the result at the end.
+	 \param merge The function combining two objects of type T in place (see InPlaceCombiner).
+	 \param root The rank of the processor receiving the result.
+	*/
+	template<typename T, typename Merge>
+	static void gather(T& data, Merge& merge, int root){
+		int procRank, nProcs;
+		MPI_Comm_rank(MPI_COMM_WORLD, &procRank);
+		MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+
+		std::vector<char> localBuffer;
+		MPI_SendRecv::pack(data, localBuffer);
+
+		// The counts and displacements of MPI_Gatherv are ints, so the total size is checked
+		// on the packed data itself, before any of them is computed.
+		long long bytes = localBuffer.size();
+		long long totalBytes;
+		MPI_Allreduce(&bytes, &totalBytes, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+		if (totalBytes > INT_MAX){
+			for (MPI_Comm comm : stages(root))
+				tree(data, merge, comm);
+			return;
+		}
+
+		int len = localBuffer.size();
+		std::vector<int> lengths(procRank==root ? nProcs : 0);
+		MPI_Gather(&len, 1, MPI_INT, lengths.data(), 1, MPI_INT, root, MPI_COMM_WORLD);
+
+		std::vector<int> displacements(lengths.size(), 0);
+		for (std::size_t i = 1; i < lengths.size(); ++i)
+			displacements[i] = displacements[i-1]+lengths[i-1];
+		std::vector<char> allBuffer;
+		if (procRank==root)
+			allBuffer.resize(displacements.back()+lengths.back());
+
+		MPI_Gatherv(localBuffer.data(), len, MPI_CHAR, allBuffer.data(), lengths.data(), displacements.data(), MPI_CHAR, root, MPI_COMM_WORLD);
+
+		if (procRank==root){
+			T result;
+			for (int i = 0; i < nProcs; ++i){
+				T part = i==root ? std::move(data) : MPI_SendRecv::unpack<T>(allBuffer.data()+displacements[i], lengths[i]);
+				if (i==0)
+					result = std::move(part);
+				else
+					merge(result, std::move(part));
+			}
+			data = std::move(result);
+		}
+	}
+
+	/**
+	 \brief This method reduces the data of all the processors in MPI_COMM_WORLD on the processor
+			'root'. The algorithm is chosen from the estimated size of the serialized data and
+			the number of processors (see 'ReduceOptions::select') : small data is gathered on
+			'root' in a single call, medium data is reduced along a k-ary tree and large data
+			along a binary tree. The trees first reduce the data inside each node (between the
+			processors sharing the same memory), and then between the nodes, so that only one
+			message per node crosses the network.
+	 \param data The data of the processor. On 'root', it contains the result at the end.
+	 \param merge The function combining two objects of type T in place. It must be associative
+			and commutative, as the data isn't combined in the order of the ranks.
+	 \param root The rank of the processor receiving the result.
+	*/
+	template<typename T, typename Merge>
+	static void reduce(T& data, Merge& merge, int root){
+		int nProcs;
+		MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+		if (nProcs == 1)
+			return;
+
+		ReduceOptions const& options = ReduceOptions::current();
+		ReduceOptions::Algorithm algorithm = options.getAlgorithm();
+		if (algorithm == ReduceOptions::Automatic){
+			// All the processors must choose the same algorithm, so the choice is based on
+			// the largest data among them. The size is only estimated, as measuring it would
+			// cost a serialization of the data on top of the one sending it.
+			long long bytes = Serialization<T>::estimateSize(data);
+			long long maxBytes;
+			MPI_Allreduce(&bytes, &maxBytes, 1, MPI_LONG_LONG, MPI_MAX, MPI_COMM_WORLD);
+
+			algorithm = options.select(maxBytes, nProcs);
+		}
+
+		if (algorithm == ReduceOptions::Gather)
+			gather(data, merge, root);
+		else if (algorithm == ReduceOptions::KaryTree){
+			int tag = nextTag();
+			for (MPI_Comm comm : stages(root))
+				karyTree(data, merge, options.getFanin(), comm, 0, tag);
+		}
+		else {
+			for (MPI_Comm comm : stages(root))
+				tree(data, merge, comm);
+		}
+	}
+
+	/**
+	 \brief This method computes on each processor of a communicator the combination of the data
+			of the processors of lower ranks, in the order of the ranks (exclusive prefix scan).
+			It takes log2(nProcs) steps : at step d, each processor sends the combination of
+			the data it knows to the processor d ranks higher, and receives the one of the
+			processor d ranks lower.
+	 \param data The data of the processor.
+	 \param merge The function combining two objects of type T in place. It must be associative,
+			but not necessarily commutative.
+	 \param before The combination of the data of the processors of lower ranks, on return.
+	 \param comm The communicator of the processors.
+	 \return false on the processor of rank 0, which has no processor before it ('before' is
+			then left unchanged), true on the other ones.
+	*/
+	template<typename T, typename Merge>
+	static bool exscan(T const& data, Merge& merge, T& before, MPI_Comm comm){
+		int procRank, nProcs;
+		MPI_Comm_rank(comm, &procRank);
+		MPI_Comm_size(comm, &nProcs);
+
+		// 'known' is the combination of the data of the processors procRank-d+1 to procRank.
+		T known(data);
+		bool hasBefore = false;
+		for (int d = 1; d < nProcs; d *= 2){
+			bool sends = procRank+d < nProcs;
+			bool receives = procRank-d >= 0;
+
+			T recvData;
+			if (sends && receives)
+				MPI_SendRecv::sendrecv(known, procRank+d, recvData, procRank-d, 0, comm);
+			else if (sends)
+				MPI_SendRecv::send(known, procRank+d, 0, comm);
+			else if (receives)
+				MPI_SendRecv::recv(recvData, procRank-d, 0, comm);
+
+			// The received data comes from lower ranks, so it is combined on the left.
+			if (receives){
+				T left(recvData);
+				merge(left, std::move(known));
+				known = std::move(left);
+
+				if (hasBefore)
+					merge(recvData, std::move(before));
+				before = std::move(recvData);
+				hasBefore = true;
+			}
+		}
+
+		return hasBefore;
+	}
+
+	/**
+	 \brief This method measures on the current machine the sizes of data up to which gathering
+			the data, and then reducing it along a k-ary tree, is faster than the binary tree,
+			and sets them in the current ReduceOptions. It must be called by all processors.
+	 \param repetitions The number of reductions timed for each size and algorithm.
+	*/
+	static void calibrate(int repetitions = 5){
+		int procRank, nProcs;
+		MPI_Comm_rank(MPI_COMM_WORLD, &procRank);
+		MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+		if (nProcs == 1)
+			return;
+
+		ReduceOptions& options = ReduceOptions::current();
+		ReduceOptions::Algorithm forced = options.getAlgorithm();
+		const ReduceOptions::Algorithm algorithms[3] = {ReduceOptions::BinaryTree, ReduceOptions::KaryTree, ReduceOptions::Gather};
+
+		// The combiner used to time the algorithms doesn't depend on the data received.
+		auto keepFirst = [](std::string&, std::string&&){};
+
+		// The thresholds are the largest sizes up to which an algorithm was always the fastest.
+		long long thresholds[2] = {0, 0};
+		bool gatherWins = true, karyWins = true;
+		for (long long bytes = 64; bytes <= 4*1024*1024 && (gatherWins || karyWins); bytes *= 4){
+			double times[3];
+			for (int a = 0; a < 3; ++a){
+				options.setAlgorithm(algorithms[a]);
+				MPI_Barrier(MPI_COMM_WORLD);
+				double start = MPI_Wtime();
+				for (int i = 0; i < repetitions; ++i){
+					std::string data(bytes, 'x');
+					reduce(data, keepFirst, 0);
+				}
+				MPI_Barrier(MPI_COMM_WORLD);
+				times[a] = MPI_Wtime()-start;
+			}
+
+			// The decisions of processor 0 are used by all of them.
+			int wins[2] = {times[2] <= times[0] && times[2] <= times[1], times[1] < times[0]};
+			MPI_Bcast(wins, 2, MPI_INT, 0, MPI_COMM_WORLD);
+			gatherWins = gatherWins && wins[0];
+			karyWins = karyWins && wins[1];
+			if (gatherWins)
+				thresholds[0] = bytes*nProcs;
+			if (karyWins)
+				thresholds[1] = bytes;
+		}
+
+		options.setAlgorithm(forced).setGatherBytes(thresholds[0]).setKaryBytes(thresholds[1]);
+	}
+
+	/**
+	 \brief This method reduces a container like 'reduce', but the containers are sent in
+			segments of 'segmentElements' elements, streamed along the tree and combined one
+			after the other (see 'sendSegments' and 'recvSegments').
+	 \param merge The function combining two containers in place. Combining a container with the
+			segments of another one must give the same result as combining it with the whole
+			container (like the union of maps or sets).
+	*/
+	template<typename T, typename Merge>
+	static void reduceSegmented(T& data, Merge& merge, std::size_t segmentElements, int root){
+		for (MPI_Comm comm : stages(root))
+			schedule(comm,
+				[&](int dest){ sendSegments(data, segmentElements, dest, 0, comm); },
+				[&](int src){ recvSegments(data, merge, src, 0, comm); });
+	}
+
+	/**
+	 \brief This method returns the tag of a new reduction. Each reduction in progress uses its
+			own tag, so that the messages of several reductions on the same communicators can't
+			be mixed. The sequence is shared by the reductions of all the types of data, and all
+			the processors must start the reductions in the same order.
+	 \return A tag between 1 and 32767.
+	*/
+	static int nextTag(){
+		static int sequence = 0;
+		sequence = sequence%32767+1;
+		return sequence;
+	}
+
+	/**
+	 \brief This method returns the communicators on which the data of the processor is reduced
+			towards 'root', in order : the communicator of its node, and then the communicator
+			of the leaders of the nodes if the processor is one of them. 'root' is rank 0 in
+			each of them.
+	*/
+	static std::vector<MPI_Comm> stages(int root){
+		Topology const& topo = topology(root);
+		std::vector<MPI_Comm> comms(1, topo.nodeComm);
+		if (topo.leadersComm != MPI_COMM_NULL)
+			comms.push_back(topo.leadersComm);
+		return comms;
+	}
+};
+
+#endif
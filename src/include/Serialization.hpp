@@ -4,15 +4,65 @@
 #include <map>
 #include <unordered_map>
 #include <string>
+#include <vector>
+#include <streambuf>
+#include <ostream>
+#include <iterator>
+#include <cstdint>
+#include <type_traits>
 #include <cereal/cereal.hpp>
 #include <cereal/types/string.hpp>
 #include <cereal/types/vector.hpp>
 #include <cereal/types/unordered_map.hpp>
+#include <cereal/types/utility.hpp>
 #include <cereal/archives/binary.hpp>
+#include "BufferArchive.hpp"
 
 template<typename Container>
 class Serialization
 {	
+	private :
+
+	/* A stream buffer counting the bytes written in it, without storing them. */
+	class CountingBuffer : public std::streambuf
+	{
+		std::streamsize count;
+
+		protected :
+
+		int_type overflow(int_type c) override {
+			if (!traits_type::eq_int_type(c, traits_type::eof()))
+				++count;
+			return traits_type::not_eof(c);
+		}
+
+		std::streamsize xsputn(const char*, std::streamsize n) override {
+			count += n;
+			return n;
+		}
+
+		public :
+
+		CountingBuffer() : count(0){}
+
+		std::streamsize size() const {
+			return count;
+		}
+	};
+
+	// Tells whether a type is a container whose size can be known and whose elements can be
+	// iterated over.
+	template<typename C, typename = void>
+	struct is_range : std::false_type {};
+
+	template<typename C>
+	struct is_range<C, std::void_t<typename C::value_type,
+		decltype(std::declval<C const&>().size()),
+		decltype(std::declval<C const&>().begin())>> : std::true_type {};
+
+	// Number of elements serialized to estimate the size of a container.
+	static const std::size_t sampleSize = 16;
+
 	public :
 	
 	/**
@@ -22,13 +72,77 @@ class Serialization
 	 \return An std::string object containing the serialized container.
 	*/
 	static std::string serialize(Container const& container){
-		std::stringstream ss;
+		std::vector<char> buffer;
+		serialize(container, buffer);
 	
-		cereal::BinaryOutputArchive oarchive(ss);
+		return std::string(buffer.begin(), buffer.end());
+	} 
+
+	/**
+	 \brief This method serializes a container at the end of a buffer. A buffer cleared and
+			reused for several serializations keeps its memory, so it is only allocated once.
+	 \param container An STL container to be serialized.
+	 \param buffer The std::vector<char> in which the serialized container is appended.
+	*/
+	static void serialize(Container const& container, std::vector<char>& buffer){
+		BufferOutputArchive oarchive(buffer);
 		oarchive(container);
+	}
+
+	/**
+	 \brief This method computes the size in bytes of a container once serialized, without
+			allocating memory for the serialized data.
+	 \param container An STL container.
+	 \return The size of the std::string that 'serialize' would return for the container.
+	*/
+	static std::size_t size(Container const& container){
+		CountingBuffer buffer;
+		std::ostream os(&buffer);
 	
-		return ss.str();
-	} 
+		{
+			cereal::BinaryOutputArchive oarchive(os);
+			oarchive(container);
+		}
+	
+		return buffer.size();
+	}
+
+	/**
+	 \brief This method estimates the size in bytes of a container once serialized, without
+			serializing all of it. The size of bitwise copyable data is known from its type,
+			and the size of a container is its number of elements times the average size of
+			its first elements. Other data is measured with 'size'.
+	 \param container An STL container.
+	 \return The estimated size of the std::string that 'serialize' would return.
+	*/
+	static std::size_t estimateSize(Container const& container){
+		if constexpr (std::is_trivially_copyable<Container>::value)
+			return sizeof(Container);
+		else if constexpr (is_range<Container>::value){
+			typedef typename Container::value_type Element;
+			// The number of elements is serialized first, on 8 bytes.
+			std::size_t nElements = container.size();
+			if constexpr (std::is_trivially_copyable<Element>::value)
+				return sizeof(std::uint64_t)+nElements*sizeof(Element);
+			else {
+				CountingBuffer buffer;
+				std::ostream os(&buffer);
+				std::size_t nSampled = 0;
+	
+				{
+					cereal::BinaryOutputArchive oarchive(os);
+					for (auto it = container.begin(); it != container.end() && nSampled < sampleSize; ++it, ++nSampled)
+						oarchive(*it);
+				}
+	
+				if (nSampled == 0)
+					return sizeof(std::uint64_t);
+				return sizeof(std::uint64_t)+(buffer.size()*nElements)/nSampled;
+			}
+		}
+		else
+			return size(container);
+	}
 
 	/**
 	 \brief This method deserializes the content of an std::string representing 
@@ -37,10 +151,20 @@ class Serialization
 	 \return The deserialized container of type 'Container' that was in the string.
 	*/
 	static Container deserialize(std::string const& serializedContainer){
-		std::stringstream ss(serializedContainer);
+		return deserialize(serializedContainer.data(), serializedContainer.size());
+	}
+
+	/**
+	 \brief This method deserializes a container directly from the memory where it was received,
+			without copying it in a stream first.
+	 \param data The address of the serialized container.
+	 \param size The size in bytes of the serialized container.
+	 \return The deserialized container of type 'Container'.
+	*/
+	static Container deserialize(const char* data, std::size_t size){
 		Container container;
 	
-		cereal::BinaryInputArchive iarchive(ss);
+		BufferInputArchive iarchive(data, size);
 		iarchive(container);
 	
 		return container;
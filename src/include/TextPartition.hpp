@@ -0,0 +1,142 @@
+#ifndef __TEXTPARTITION_H__
+#define __TEXTPARTITION_H__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "FileError.hpp"
+
+class TextPartition
+{
+	private :
+
+	/* The bytes of a partition : either a region of the file mapped in memory,
+	   or a buffer in which the region was read when it couldn't be mapped. */
+	class Region
+	{
+		public :
+
+		void* mapAddr;
+		std::size_t mapLength;
+		std::vector<char> buffer;
+
+		Region() : mapAddr(nullptr), mapLength(0){}
+
+		~Region(){
+			if (mapAddr != nullptr)
+				munmap(mapAddr, mapLength);
+		}
+	};
+
+	// The region is shared by all the copies of a partition, and unmapped
+	// when the last of them is destroyed.
+	std::shared_ptr<Region> region;
+	std::string_view text;
+	char delimiter;
+
+	TextPartition(std::shared_ptr<Region> bytes, std::string_view view, char delim) : region(bytes), text(view), delimiter(delim){}
+
+	public :
+
+	TextPartition() : delimiter('\n'){}
+
+	/**
+	 \brief This method loads the bytes [begin, end) of a file in a new TextPartition. The bytes
+			are mapped in memory whenever possible (they are then only read from the disk when
+			they are accessed), and read once in a buffer otherwise.
+	 \param filename The name (path) of the file.
+	 \param begin The offset of the first byte of the partition in the file.
+	 \param end The offset right after the last byte of the partition in the file.
+	 \param delimiter The character separating the records of the partition.
+	 \return A TextPartition object giving access to the bytes [begin, end) of the file.
+	*/
+	static TextPartition load(std::string const& filename, long long begin, long long end, char delimiter){
+		std::shared_ptr<Region> bytes = std::make_shared<Region>();
+		if (end <= begin)
+			return TextPartition(bytes, std::string_view(), delimiter);
+
+		int fd = open(filename.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw FileError();
+
+		// mmap() needs an offset that is a multiple of the page size, so the mapping
+		// may start a few bytes before the partition.
+		long long page = sysconf(_SC_PAGESIZE);
+		long long mapBegin = begin - begin%page;
+		std::size_t length = end-mapBegin;
+		void* addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, mapBegin);
+
+		const char* first;
+		if (addr != MAP_FAILED){
+			madvise(addr, length, MADV_SEQUENTIAL);
+			bytes->mapAddr = addr;
+			bytes->mapLength = length;
+			first = static_cast<const char*>(addr) + (begin-mapBegin);
+		}
+		else {
+			bytes->buffer.resize(end-begin);
+			std::size_t done = 0;
+			while (done < bytes->buffer.size()){
+				ssize_t n = pread(fd, bytes->buffer.data()+done, bytes->buffer.size()-done, begin+done);
+				if (n <= 0){
+					close(fd);
+					throw FileError();
+				}
+				done += n;
+			}
+			first = bytes->buffer.data();
+		}
+		close(fd);
+
+		return TextPartition(bytes, std::string_view(first, end-begin), delimiter);
+	}
+
+	/**
+	 \brief This method returns a view on the whole text of the partition, without copying it.
+	*/
+	std::string_view view() const {
+		return text;
+	}
+
+	std::size_t size() const {
+		return text.size();
+	}
+
+	char getDelimiter() const {
+		return delimiter;
+	}
+
+	/**
+	 \brief This method calls 'func' on each record of the partition (the strings between two
+			delimiters, without the delimiters). The records are passed as std::string_view
+			objects pointing directly in the partition, so no copy of the text is made.
+	 \param func A function or lambda function taking an std::string_view as parameter.
+	*/
+	template<typename F>
+	void forEachRecord(F func) const {
+		std::size_t pos = 0;
+		while (pos < text.size()){
+			std::size_t next = text.find(delimiter, pos);
+			if (next == std::string_view::npos)
+				next = text.size();
+			func(text.substr(pos, next-pos));
+			pos = next+1;
+		}
+	}
+
+	/**
+	 \brief This method returns the records of the partition in a vector of std::string_view
+			objects pointing in the partition (see 'forEachRecord').
+	*/
+	std::vector<std::string_view> records() const {
+		std::vector<std::string_view> result;
+		forEachRecord([&result](std::string_view record){ result.push_back(record); });
+		return result;
+	}
+};
+
+#endif
@@ -4,7 +4,16 @@
 #include "./MPI_Context.hpp"
 #include "./Serialization.hpp"
 #include "./MPI_SendRecv.hpp"
+#include "./MPI_Types.hpp"
+#include "./ReduceOps.hpp"
+#include "./Reduction.hpp"
+#include "./PendingReduce.hpp"
 #include "./DistributedData.hpp"
 #include "./ReducedData.hpp"
+#include "./TextPartition.hpp"
+#include "./IOOptions.hpp"
+#include "./ReduceOptions.hpp"
+#include "./CompressionOptions.hpp"
+#include "./Compression.hpp"
 
 #endif